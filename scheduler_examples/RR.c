@@ -15,25 +15,22 @@
  * Passo a passo da função rr_scheduler:
  *
  * 1. Contabilização de tempo:
- *    - A cada chamada do escalonador, simula-se a passagem de TICKS_MS (1 ms).
- *    - Esse tempo é adicionado tanto ao tempo total de execução do processo
- *      (ellapsed_time_ms) quanto ao contador do quantum (quantum_counter).
+ *    - A cada chamada do escalonador, simula-se a passagem de TICKS_MS.
+ *    - Esse tempo é adicionado ao tempo total de execução do processo
+ *      (ellapsed_time_ms); o quantum conta-se a partir de slice_start_ms.
  *
  * 2. Se o processo terminou (ellapsed_time_ms >= time_ms):
  *    - Envia mensagem ao processo notificando que ele terminou (PROCESS_REQUEST_DONE).
- *    - Liberta a memória do PCB.
- *    - A CPU fica livre (*cpu_task = NULL).
- *    - Reinicia o contador de quantum.
+ *    - A CPU fica livre (*cpu_task = NULL) e o processo volta à command queue.
  *
- * 3. Se o processo não terminou, mas gastou todo o quantum (quantum_counter >= QUANTUM_MS):
+ * 3. Se o processo não terminou, mas gastou todo o quantum (QUANTUM_MS ou --rr-quantum):
  *    - O processo é removido da CPU e colocado no final da fila de prontos (enqueue_pcb).
  *    - A CPU fica livre.
- *    - Reinicia o contador de quantum.
  *    - Assim, outro processo terá chance de executar no próximo ciclo.
  *
  * 4. Se a CPU está livre (*cpu_task == NULL) e existe processo na fila:
  *    - O escalonador pega o próximo processo da fila (dequeue_pcb).
- *    - Coloca-o na CPU para ser executado nos próximos ticks.
+ *    - Coloca-o na CPU e marca o início do quantum (slice_start_ms).
  */
 
 
@@ -43,62 +40,100 @@
 //Se não termina dentro do quantum → volta para o fim da fila.
 //CPU nunca fica ociosa enquanto houver processos prontos.
 
-#include "msg.h"
-#include "queue.h"
-#include <unistd.h>
+#include "RR.h"
+
 #include <stdio.h>
 #include <stdlib.h>
 
-#define TICKS_MS    1      // Cada tick equivale a 1 ms (tempo simulado)
-#define QUANTUM_MS  10     // Quantum = tempo máximo que um processo pode rodar de uma vez (10ms aqui)
-
-// Função de escalonamento Round-Robin
-void rr_scheduler(uint32_t current_time_ms, queue_t *rq, pcb_t **cpu_task) {
-    // Contador estático que acumula quanto tempo o processo atual já rodou no quantum
-    static uint32_t quantum_counter = 0;
+// Estado da fila de prontos do Round-Robin
+typedef struct {
+    queue_t queue;
+    uint32_t quantum_ms;
+} rr_ready_t;
 
+static void rr_step(uint32_t current_time_ms, queue_t *rq, uint32_t quantum_ms, pcb_t **cpu_task) {
     // Verifica se existe um processo em execução na CPU
     if (*cpu_task) {
         // Incrementa o tempo total que o processo já rodou
         (*cpu_task)->ellapsed_time_ms += TICKS_MS;
-        // Incrementa o tempo rodado no quantum atual
-        quantum_counter += TICKS_MS;
 
         // Caso 1: o processo terminou (tempo de execução >= tempo requerido)
         if ((*cpu_task)->ellapsed_time_ms >= (*cpu_task)->time_ms) {
-            // Prepara mensagem para notificar que o processo acabou
-            msg_t msg = {
-                .pid = (*cpu_task)->pid,
-                .request = PROCESS_REQUEST_DONE,
-                .time_ms = current_time_ms
-            };
-
-            // Envia mensagem ao processo pela sua socket
-            if (write((*cpu_task)->sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
-                perror("write");
-            }
-
-            // Liberta a memória do processo finalizado
-            free(*cpu_task);
+            // Notifica o processo que o burst acabou; o ciclo principal devolve-o à command queue
+            finish_burst(*cpu_task, current_time_ms);
             *cpu_task = NULL;
-            quantum_counter = 0; // reinicia contador de quantum
         }
         // Caso 2: o quantum expirou mas o processo ainda não terminou
-        else if (quantum_counter >= QUANTUM_MS) {
+        else if (quantum_expired(*cpu_task, quantum_ms, current_time_ms)) {
             // Reinsere o processo no fim da fila de prontos
+            preempt_burst(*cpu_task);
             enqueue_pcb(rq, *cpu_task);
             *cpu_task = NULL;     // CPU fica livre
-            quantum_counter = 0;  // reinicia contador de quantum
         }
     }
+}
 
-    // Se não há processo em execução e a fila não está vazia
-    if (*cpu_task == NULL && rq->head != NULL) {
-        // Remove o próximo processo da fila
-        pcb_t *next_pcb = dequeue_pcb(rq);
-        if (next_pcb) {
-            // Coloca esse processo na CPU
-            *cpu_task = next_pcb;
-        }
+static pcb_t *rr_next(queue_t *rq, uint32_t current_time_ms) {
+    // Remove o próximo processo da fila
+    pcb_t *next_pcb = dequeue_pcb(rq);
+    if (next_pcb) {
+        next_pcb->slice_start_ms = current_time_ms;   // Início do quantum
+    }
+    return next_pcb;
+}
+
+// Função de escalonamento Round-Robin
+void rr_scheduler(uint32_t current_time_ms, queue_t *rq, pcb_t **cpu_task) {
+    rr_step(current_time_ms, rq, QUANTUM_MS, cpu_task);
+
+    // Se não há processo em execução, coloca o próximo da fila na CPU
+    if (*cpu_task == NULL) {
+        *cpu_task = rr_next(rq, current_time_ms);
     }
 }
+
+static void *rr_init(const policy_config_t *config) {
+    rr_ready_t *rq = calloc(1, sizeof(rr_ready_t));
+    if (!rq) return NULL;
+    rq->quantum_ms = config->rr_quantum_ms ? config->rr_quantum_ms : QUANTUM_MS;
+    return rq;
+}
+
+static int rr_enqueue(void *rq, pcb_t *task) {
+    return enqueue_pcb(&((rr_ready_t *)rq)->queue, task);
+}
+
+static void rr_tick(void *rq, uint32_t current_time_ms, pcb_t **cpu_task) {
+    rr_step(current_time_ms, &((rr_ready_t *)rq)->queue, ((rr_ready_t *)rq)->quantum_ms, cpu_task);
+}
+
+static pcb_t *rr_pick(void *rq, uint32_t current_time_ms) {
+    return rr_next(&((rr_ready_t *)rq)->queue, current_time_ms);
+}
+
+static uint32_t rr_ready_count(const void *rq) {
+    return ((const rr_ready_t *)rq)->queue.count;
+}
+
+static uint32_t rr_quantum_ms(const void *rq, const pcb_t *task) {
+    (void)task;
+    return ((const rr_ready_t *)rq)->quantum_ms;
+}
+
+static int rr_set_quantum(void *rq, uint32_t level, uint32_t quantum_ms) {
+    if (level != 0) return -1;
+    ((rr_ready_t *)rq)->quantum_ms = quantum_ms;
+    return 0;
+}
+
+const scheduler_policy_t rr_policy = {
+    .name = "RR",
+    .init = rr_init,
+    .enqueue = rr_enqueue,
+    .tick = rr_tick,
+    .pick = rr_pick,
+    .ready_count = rr_ready_count,
+    .quantum_ms = rr_quantum_ms,
+    .destroy = free,
+    .set_quantum = rr_set_quantum,
+};
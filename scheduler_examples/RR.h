@@ -3,14 +3,15 @@
 
 
 #include "msg.h"
+#include "policy.h"
 #include "queue.h"
-#include <unistd.h>
-#include <stdio.h>
-#include <stdlib.h>
+
+#define QUANTUM_MS  10     // Quantum por omissão = tempo máximo que um processo pode rodar de uma vez
 
 
 void rr_scheduler(uint32_t current_time_ms, queue_t *rq, pcb_t **cpu_task);
 
+extern const scheduler_policy_t rr_policy;
 
 
 #endif //RR_H
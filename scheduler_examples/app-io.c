@@ -1,8 +1,8 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <sys/socket.h>
-#include <sys/un.h>
+#include <string.h>
 #include <fcntl.h>
+#include <getopt.h>
 #include <limits.h>
 #include <unistd.h>
 
@@ -11,6 +11,11 @@
 
 #include "msg.h"
 #include "burst_queue.h"
+#include "histogram.h"
+#include "transport.h"
+
+// Wall time from sending a request to receiving its ACK, per request type
+static histogram_t ack_latency[PROCESS_REQUEST_SUBMIT + 1];
 
 /**
  * Extracts the basename of a file without its extension.
@@ -38,39 +43,38 @@ typedef enum {
     process_terminated
 } process_status_en;
 
-process_status_en handle_process_requests(int sockfd, const pid_t pid, const char *app_name, burst_t *burst, process_request_t request, uint32_t *sim_start_time_ms, uint32_t *sim_clock_ms) {
+process_status_en handle_process_requests(client_conn_t *conn, const pid_t pid, const char *app_name, burst_t *burst, process_request_t request, uint32_t *sim_start_time_ms, uint32_t *sim_clock_ms) {
     msg_t msg = {
         .pid = pid,
         .request = request,
         .time_ms = (request == PROCESS_REQUEST_RUN)?burst->burst_time_ms:burst->block_time_ms
     };
     // Send request
-    if (write(sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
+    uint64_t sent_ns = monotonic_ns();
+    if (client_write(conn, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
         perror("write");
-        close(sockfd);
         return process_error;
     }
     DBG("Application %s (PID %d) sent %s request for %u ms",
            app_name, pid, PROCESS_REQUEST_STRINGS[request], msg.time_ms);
     // Wait for ACK and the internal simulation time
-    if (read(sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
+    if (client_read(conn, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
         perror("read");
-        close(sockfd);
         return process_error;
     }
     if (msg.request != PROCESS_REQUEST_ACK) {
         printf("Received invalid request. Expected ACK, received %s\n", PROCESS_REQUEST_STRINGS[msg.request]);
         return process_error;
     }
+    histogram_record(&ack_latency[request], monotonic_ns() - sent_ns);
     *sim_clock_ms = msg.time_ms;
     if (*sim_start_time_ms == 0) *sim_start_time_ms = *sim_clock_ms; // First burst, set the start time
     printf("Received %s from scheduler for application %s (PID %d) at time %u ms\n",
            PROCESS_REQUEST_STRINGS[msg.request], app_name, pid, *sim_clock_ms);
 
     // Wait for DONE and the internal simulation time
-    if (read(sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
+    if (client_read(conn, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
         perror("read");
-        close(sockfd);
         return process_error;
     }
 
@@ -85,40 +89,123 @@ process_status_en handle_process_requests(int sockfd, const pid_t pid, const cha
     return process_success;
 }
 
+/**
+ * Submits a window of bursts in one message and waits for the simulator to run all of them.
+ * The simulator answers with an ACK when it accepts the bursts and a single DONE after the
+ * block of the last one, instead of an ACK and a DONE per RUN and per BLOCK.
+ */
+process_status_en handle_process_submit(client_conn_t *conn, const pid_t pid, const char *app_name, const burst_msg_t *bursts, uint32_t count, uint32_t *sim_start_time_ms, uint32_t *sim_clock_ms) {
+    size_t len = sizeof(msg_t) + count * sizeof(burst_msg_t);
+    char *buffer = malloc(len);
+    if (!buffer) {
+        perror("malloc");
+        return process_error;
+    }
+    msg_t msg = {
+        .pid = pid,
+        .request = PROCESS_REQUEST_SUBMIT,
+        .time_ms = count
+    };
+    memcpy(buffer, &msg, sizeof(msg_t));
+    memcpy(buffer + sizeof(msg_t), bursts, count * sizeof(burst_msg_t));
+
+    // Send the request and the bursts at once
+    uint64_t sent_ns = monotonic_ns();
+    if (client_write(conn, buffer, len) != (ssize_t)len) {
+        perror("write");
+        free(buffer);
+        return process_error;
+    }
+    free(buffer);
+    DBG("Application %s (PID %d) sent %s request for %u bursts", app_name, pid, PROCESS_REQUEST_STRINGS[msg.request], count);
+
+    // Wait for ACK, then for the DONE of the last burst
+    process_request_t expected[] = {PROCESS_REQUEST_ACK, PROCESS_REQUEST_DONE};
+    for (int i = 0; i < 2; i++) {
+        if (client_read(conn, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
+            perror("read");
+            return process_error;
+        }
+        if (msg.request != expected[i]) {
+            printf("Received invalid request. Expected %s, received %s\n",
+                   PROCESS_REQUEST_STRINGS[expected[i]], PROCESS_REQUEST_STRINGS[msg.request]);
+            return process_error;
+        }
+        if (i == 0) histogram_record(&ack_latency[PROCESS_REQUEST_SUBMIT], monotonic_ns() - sent_ns);
+        *sim_clock_ms = msg.time_ms;
+        if (*sim_start_time_ms == 0) *sim_start_time_ms = *sim_clock_ms; // First burst, set the start time
+        printf("Received %s from scheduler for application %s (PID %d) at time %u ms\n",
+               PROCESS_REQUEST_STRINGS[msg.request], app_name, pid, *sim_clock_ms);
+    }
+    return process_success;
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options] <burst-file>    (text .csv or binary, see csv2bin)\n", prog);
+    printf("  -s, --submit       send all bursts in one SUBMIT request instead of a RUN and a BLOCK per burst\n");
+    printf("  -w, --window N     send the bursts in SUBMIT requests of N bursts\n");
+    printf("  -m, --shm          talk to the simulator through shared memory instead of the socket\n");
+}
+
 /*
- * Run like: ./app-pre <burst-file.csv>
+ * Run like: ./app-pre [-m] [-s | -w N] <burst-file.csv>
  */
 int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        printf("Usage: %s <burst-file.csv>\n", argv[0]);
+    uint32_t window = 0;                    // Bursts per SUBMIT, 0 for the RUN/BLOCK protocol
+    transport_en transport = TRANSPORT_SOCKET;
+
+    static const struct option long_options[] = {
+        {"submit", no_argument, NULL, 's'},
+        {"window", required_argument, NULL, 'w'},
+        {"shm", no_argument, NULL, 'm'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "msw:", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'm':
+                transport = TRANSPORT_SHM;
+                break;
+            case 's':
+                window = MAX_SUBMIT_BURSTS;
+                break;
+            case 'w': {
+                char *endptr;
+                long value = strtol(optarg, &endptr, 10);
+                if (*endptr != '\0' || value <= 0 || value > MAX_SUBMIT_BURSTS) {
+                    fprintf(stderr, "Invalid window: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                window = (uint32_t)value;
+                break;
+            }
+            default:
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (optind != argc - 1) {
+        print_usage(argv[0]);
         exit(EXIT_FAILURE);
     }
 
     // Parse arguments
-    const char *burstfile_name = argv[1];
+    const char *burstfile_name = argv[optind];
     char *app_name = get_basename_no_ext(burstfile_name);
 
-    burst_queue_t bursts = {.head = NULL, .tail = NULL};
-
-    if (read_queue_from_file(&bursts, burstfile_name) <= 0) {
+    // Bursts are decoded one at a time from the mapped file
+    burst_reader_t reader;
+    burst_t burst;
+    int have_burst = -1;
+    if (burst_reader_open(&reader, burstfile_name) == 0) have_burst = burst_reader_next(&reader, &burst);
+    if (have_burst <= 0) {
         fprintf(stderr, "Failed to read burst file %s\n", burstfile_name);
         return EXIT_FAILURE;
     }
 
-    // Setup socket for communication
-    int sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
-    if (sockfd < 0) {
-        perror("socket");
-        return EXIT_FAILURE;
-    }
-
-    struct sockaddr_un addr = {0};
-    addr.sun_family = AF_UNIX;
-    strncpy(addr.sun_path, SOCKET_PATH, sizeof(addr.sun_path) - 1);
-
-    if (connect(sockfd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        perror("connect");
-        close(sockfd);
+    // Connect to the scheduler
+    client_conn_t conn;
+    if (client_connect(&conn, transport) < 0) {
         return EXIT_FAILURE;
     }
 
@@ -130,16 +217,40 @@ int main(int argc, char *argv[]) {
 
     burst_t *active_burst;
 
-    while ((active_burst = dequeue_burst(&bursts)) != NULL) {
-        if (handle_process_requests(sockfd, pid, app_name, active_burst, PROCESS_REQUEST_RUN, &start_time_ms, &sim_clock_ms) == process_error)
+    if (window > 0) {
+        burst_msg_t *pending = malloc(window * sizeof(burst_msg_t));
+        uint32_t count = 0;
+        while (pending) {
+            active_burst = have_burst > 0 ? &burst : NULL;
+            if (active_burst) {
+                pending[count].burst_time_ms = active_burst->burst_time_ms;
+                pending[count].block_time_ms = active_burst->block_time_ms;
+                count++;
+                app_duration_ms += active_burst->burst_time_ms + active_burst->block_time_ms;
+                have_burst = burst_reader_next(&reader, &burst);
+            }
+            if (count == window || (!active_burst && count > 0)) {
+                if (handle_process_submit(&conn, pid, app_name, pending, count, &start_time_ms, &sim_clock_ms) == process_error)
+                    break;
+                count = 0;
+            }
+            if (!active_burst) break;
+        }
+        free(pending);
+    }
+
+    while (window == 0 && have_burst > 0) {
+        active_burst = &burst;
+        if (handle_process_requests(&conn, pid, app_name, active_burst, PROCESS_REQUEST_RUN, &start_time_ms, &sim_clock_ms) == process_error)
             break;
         app_duration_ms += active_burst->burst_time_ms;
 
         if (active_burst->block_time_ms > 0) {
-            if (handle_process_requests(sockfd, pid, app_name, active_burst, PROCESS_REQUEST_BLOCK, &start_time_ms, &sim_clock_ms) == process_error)
+            if (handle_process_requests(&conn, pid, app_name, active_burst, PROCESS_REQUEST_BLOCK, &start_time_ms, &sim_clock_ms) == process_error)
                 break;
             app_duration_ms += active_burst->block_time_ms;
         }
+        have_burst = burst_reader_next(&reader, &burst);
     }
 
     // Received EXIT, print stats
@@ -149,7 +260,13 @@ int main(int argc, char *argv[]) {
     printf("Application %s (PID %d) finished at time %d ms, Elapsed: %.03f seconds, CPU: %.03f seconds\n",
            app_name, pid, sim_clock_ms, real, user);
 
-    close(sockfd);
+    print_histogram_header(stdout, "Round trip (us, wall time)");
+    print_histogram_line(stdout, "RUN to ACK", &ack_latency[PROCESS_REQUEST_RUN]);
+    print_histogram_line(stdout, "BLOCK to ACK", &ack_latency[PROCESS_REQUEST_BLOCK]);
+    print_histogram_line(stdout, "SUBMIT to ACK", &ack_latency[PROCESS_REQUEST_SUBMIT]);
+
+    client_close(&conn);
+    burst_reader_close(&reader);
     free(app_name);
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -1,7 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <sys/socket.h>
-#include <sys/un.h>
+#include <string.h>
 #include <fcntl.h>
 #include <limits.h>
 #include <unistd.h>
@@ -9,14 +8,22 @@
 
 #include "debug.h"
 
+#include "histogram.h"
 #include "msg.h"
+#include "transport.h"
 
 /*
- * Run like: ./app <name> <time_s>
+ * Run like: ./app [--shm] <name> <time_s>
  */
 int main(int argc, char *argv[]) {
+    transport_en transport = TRANSPORT_SOCKET;
+    if (argc == 4 && (strcmp(argv[1], "-m") == 0 || strcmp(argv[1], "--shm") == 0)) {
+        transport = TRANSPORT_SHM;
+        argc--;
+        argv++;
+    }
     if (argc != 3) {
-        printf("Usage: %s <name> <time_s>\n", argv[0]);
+        printf("Usage: %s [--shm] <name> <time_s>\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
@@ -39,20 +46,9 @@ int main(int argc, char *argv[]) {
     }
     int32_t time_s = (int32_t) val;
 
-    // Setup socket for communication
-    int sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
-    if (sockfd < 0) {
-        perror("socket");
-        return EXIT_FAILURE;
-    }
-
-    struct sockaddr_un addr = {0};
-    addr.sun_family = AF_UNIX;
-    strncpy(addr.sun_path, SOCKET_PATH, sizeof(addr.sun_path) - 1);
-
-    if (connect(sockfd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        perror("connect");
-        close(sockfd);
+    // Connect to the scheduler
+    client_conn_t conn;
+    if (client_connect(&conn, transport) < 0) {
         return EXIT_FAILURE;
     }
 
@@ -61,22 +57,24 @@ int main(int argc, char *argv[]) {
 
     // Send RUN request
     pid_t pid = getpid();
+    static histogram_t ack_latency;         // Wall time from sending RUN to receiving its ACK
+    uint64_t sent_ns = monotonic_ns();
     msg_t msg = {
         .pid = pid,
         .request = PROCESS_REQUEST_RUN,
         .time_ms = time_s * 1000
     };
-    if (write(sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
+    if (client_write(&conn, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
         perror("write");
-        close(sockfd);
+        client_close(&conn);
         return EXIT_FAILURE;
     }
     DBG("Application %s (PID %d) sent RUN request for %d ms",
            app_name, pid, msg.time_ms);
     // Wait for ACK and the internal simulation time
-    if (read(sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
+    if (client_read(&conn, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
         perror("read");
-        close(sockfd);
+        client_close(&conn);
         return EXIT_FAILURE;
     }
     if (msg.request != PROCESS_REQUEST_ACK) {
@@ -85,13 +83,14 @@ int main(int argc, char *argv[]) {
     }
 
     // Received ACK
+    histogram_record(&ack_latency, monotonic_ns() - sent_ns);
     uint32_t start_time_ms = msg.time_ms;
 //    printf("Application %s (PID %d) started running at time %d ms\n", app_name, pid, start_time_ms);
 
     // Wait for the EXIT message
-    if (read(sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
+    if (client_read(&conn, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
         perror("read");
-        close(sockfd);
+        client_close(&conn);
         return EXIT_FAILURE;
     }
     if (msg.request != PROCESS_REQUEST_DONE) {
@@ -105,7 +104,9 @@ int main(int argc, char *argv[]) {
 
     printf("Application %s (PID %d) finished at time %d ms, Elapsed: %.03f seconds, CPU: %.03f seconds\n",
            app_name, pid, msg.time_ms, real, user);
+    print_histogram_header(stdout, "Round trip (us, wall time)");
+    print_histogram_line(stdout, "RUN to ACK", &ack_latency);
 
-    close(sockfd);
+    client_close(&conn);
     return EXIT_SUCCESS;
 }
\ No newline at end of file
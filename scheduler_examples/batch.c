@@ -0,0 +1,217 @@
+#include "batch.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "burst_queue.h"
+#include "event_queue.h"
+#include "machine.h"
+#include "metrics.h"
+#include "msg.h"
+#include "queue.h"
+#include "scenario.h"
+#include "trace.h"
+
+// State of one simulated application, the in-process equivalent of app-io
+typedef struct {
+    pcb_t *pcb;
+    const batch_workload_t *workload;
+    uint32_t next_burst;            // Index of the burst the next request refers to
+    int blocking;                   // Next request is the BLOCK of next_burst instead of its RUN
+    int started;
+    uint32_t start_time_ms;         // Time of the first ACK
+    uint32_t sim_clock_ms;          // Time of the last ACK/DONE, as app-io sees it
+    uint32_t app_duration_ms;       // Sum of the bursts and blocks requested so far
+} batch_task_t;
+
+// State of one simulation, the scenario itself is only read
+typedef struct {
+    batch_task_t *tasks;
+    event_queue_t events;
+    metrics_t metrics;
+    uint32_t blocked;               // Applications in a BLOCK, for the trace
+} batch_run_t;
+
+// The done handler has no context argument, each thread runs one simulation at a time
+static _Thread_local batch_run_t *current_run = NULL;
+
+static batch_task_t *task_of(batch_run_t *run, const pcb_t *pcb) {
+    return &run->tasks[pcb->pid - 1];
+}
+
+/**
+ * @brief Done handler: the application sees DONE and answers with its next request one tick later.
+ */
+static void batch_done(pcb_t *pcb, uint32_t current_time_ms) {
+    batch_task_t *task = task_of(current_run, pcb);
+    task->sim_clock_ms = current_time_ms;
+    if (task->blocking || task->workload->bursts[task->next_burst].block_time_ms == 0) {
+        task->blocking = 0;
+        task->next_burst++;
+    } else {
+        task->blocking = 1;
+    }
+    push_event(&current_run->events, current_time_ms + TICKS_MS, EVENT_TASK_REQUEST, pcb);
+}
+
+/**
+ * @brief Handles the next request of an application, as check_new_commands does for sockets.
+ *
+ * @return 1 if the application has no bursts left and finished, 0 otherwise.
+ */
+static int batch_request(batch_run_t *run, pcb_t *pcb, uint32_t current_time_ms,
+                         machine_t *machine, FILE *report, batch_result_t *result) {
+    batch_task_t *task = task_of(run, pcb);
+    const batch_workload_t *workload = task->workload;
+
+    if (task->next_burst == workload->count) {
+        double real = (task->sim_clock_ms - task->start_time_ms) / 1000.0;
+        double user = (double)task->app_duration_ms / 1000.0;
+        if (report) {
+            fprintf(report, "Application %s (PID %d) finished at time %u ms, Elapsed: %.03f seconds, CPU: %.03f seconds\n",
+                    workload->name, pcb->pid, task->sim_clock_ms, real, user);
+        }
+        result->avg_elapsed_s += real;
+        if (real > result->max_elapsed_s) result->max_elapsed_s = real;
+        metrics_task_exit(&run->metrics, pcb);
+        free(pcb);
+        task->pcb = NULL;
+        return 1;
+    }
+
+    const burst_msg_t *burst = &workload->bursts[task->next_burst];
+    task->sim_clock_ms = current_time_ms;       // ACK
+    if (!task->started) {
+        task->started = 1;
+        task->start_time_ms = current_time_ms;
+    }
+
+    if (!task->blocking) {
+        pcb->time_ms = burst->burst_time_ms;
+        pcb->ellapsed_time_ms = 0;
+        pcb->status = TASK_RUNNING;
+        task->app_duration_ms += burst->burst_time_ms;
+        metrics_burst_arrival(&run->metrics, pcb, current_time_ms);
+        machine_enqueue(machine, pcb);
+        trace_event(TRACE_ENQUEUE, current_time_ms, pcb, pcb->time_ms, machine_ready_count(machine), run->blocked);
+    } else {
+        pcb->time_ms = burst->block_time_ms;
+        pcb->status = TASK_BLOCKED;
+        task->app_duration_ms += burst->block_time_ms;
+        // Same wake-up tick as the timing wheel of the socket-driven simulator
+        uint32_t ticks = (burst->block_time_ms + TICKS_MS - 1) / TICKS_MS;
+        pcb->wake_time_ms = current_time_ms + (ticks > 0 ? ticks - 1 : 0) * TICKS_MS;
+        push_event(&run->events, pcb->wake_time_ms, EVENT_BLOCK_EXPIRED, pcb);
+        run->blocked++;
+        trace_event(TRACE_BLOCK, current_time_ms, pcb, pcb->wake_time_ms, machine_ready_count(machine), run->blocked);
+    }
+    trace_event(TRACE_ACK, current_time_ms, pcb, pcb->time_ms, machine_ready_count(machine), run->blocked);
+    return 0;
+}
+
+int simulate_batch(const batch_scenario_t *scenario, const scheduler_policy_t *policy,
+                   const policy_config_t *config, uint32_t num_cpus, FILE *report, batch_result_t *result) {
+    memset(result, 0, sizeof(*result));
+
+    batch_run_t run = {0};
+    run.tasks = calloc(scenario->num_apps, sizeof(batch_task_t));
+    if (!run.tasks) return -1;
+    for (uint32_t i = 0; i < scenario->num_apps; i++) {
+        batch_task_t *task = &run.tasks[i];
+        task->workload = &scenario->workloads[scenario->apps[i].workload];
+        task->pcb = new_pcb((int32_t)(i + 1), 0, 0);
+        if (!task->pcb || !push_event(&run.events, scenario->apps[i].arrival_ms, EVENT_TASK_REQUEST, task->pcb)) {
+            fprintf(stderr, "Out of memory creating application %u\n", i + 1);
+            for (uint32_t j = 0; j <= i; j++) free(run.tasks[j].pcb);
+            free(run.tasks);
+            free_event_queue(&run.events);
+            return -1;
+        }
+    }
+
+    machine_t machine;
+    if (machine_init(&machine, policy, config, num_cpus) < 0) {
+        fprintf(stderr, "Failed to initialize the %s scheduler\n", policy->name);
+        for (uint32_t i = 0; i < scenario->num_apps; i++) free(run.tasks[i].pcb);
+        free(run.tasks);
+        free_event_queue(&run.events);
+        return -1;
+    }
+    run.metrics.num_cpus = num_cpus;
+    current_run = &run;
+    set_done_handler(batch_done);
+
+    struct timespec wall_start, wall_end;
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+
+    uint32_t current_time_ms = 0;
+    while (result->apps < scenario->num_apps) {
+        // Requests and wake-ups due now, in the order they were scheduled
+        event_t ev;
+        while (peek_event(&run.events) && peek_event(&run.events)->time_ms <= current_time_ms) {
+            pop_event(&run.events, &ev);
+            if (ev.type == EVENT_TASK_REQUEST) {
+                result->apps += batch_request(&run, ev.pcb, current_time_ms, &machine, report, result);
+            } else if (ev.type == EVENT_BLOCK_EXPIRED) {
+                run.blocked--;
+                trace_event(TRACE_WAKE, current_time_ms, ev.pcb, 0, machine_ready_count(&machine), run.blocked);
+                batch_done(ev.pcb, current_time_ms);
+            }
+        }
+
+        machine_tick(&machine, current_time_ms);
+        for (uint32_t c = 0; c < machine.num_cpus; c++) {
+            metrics_cpu_switch(&run.metrics, machine.cpus[c].prev, machine.cpus[c].task, machine.cpus[c].preempted,
+                               current_time_ms);
+            trace_cpu_switch(machine.cpus[c].prev, machine.cpus[c].task, machine.cpus[c].preempted, c,
+                             current_time_ms, machine_ready_count(&machine), run.blocked);
+        }
+
+        // Jump to the next tick where something happens
+        uint32_t next_ms = machine_next_event_ms(&machine, current_time_ms);
+        if (peek_event(&run.events) && peek_event(&run.events)->time_ms < next_ms) {
+            next_ms = peek_event(&run.events)->time_ms;
+        }
+        if (next_ms == UINT32_MAX) break;
+        machine_skip(&machine, next_ms - current_time_ms - TICKS_MS);
+        current_time_ms = next_ms;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    result->wall_s = (double)(wall_end.tv_sec - wall_start.tv_sec) + (wall_end.tv_nsec - wall_start.tv_nsec) / 1e9;
+    result->makespan_ms = current_time_ms;
+    if (result->apps > 0) result->avg_elapsed_s /= result->apps;
+    if (summarize_metrics(&run.metrics, &result->metrics) < 0) perror("summarize_metrics");
+    for (uint32_t c = 0; c < machine.num_cpus; c++) {
+        result->migrations += machine.cpus[c].migrations;
+    }
+    if (report) {
+        print_metrics(&run.metrics, report);
+        print_cpu_stats(&machine, &run.metrics, report);
+    }
+
+    set_done_handler(NULL);
+    current_run = NULL;
+    machine_destroy(&machine);
+    free_event_queue(&run.events);
+    free_metrics(&run.metrics);
+    for (uint32_t i = 0; i < scenario->num_apps; i++) free(run.tasks[i].pcb);
+    free(run.tasks);
+    return result->apps == scenario->num_apps ? 0 : -1;
+}
+
+int run_batch(const char *scenario_file, const scheduler_policy_t *policy, const policy_config_t *config,
+              uint32_t num_cpus) {
+    batch_scenario_t *scenario = load_scenario(scenario_file);
+    if (!scenario) return -1;
+
+    batch_result_t result;
+    int ret = simulate_batch(scenario, policy, config, num_cpus, stdout, &result);
+    printf("Batch %s with %s on %u CPU%s: %u applications finished at time %u ms, simulated in %.03f seconds\n",
+           scenario_file, policy->name, num_cpus, num_cpus == 1 ? "" : "s", result.apps, result.makespan_ms,
+           result.wall_s);
+
+    free_scenario(scenario);
+    return ret;
+}
@@ -0,0 +1,52 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "metrics.h"
+#include "policy.h"
+#include "scenario.h"
+
+// Summary of one batch simulation
+typedef struct {
+    uint32_t apps;                  // Applications that finished
+    uint32_t makespan_ms;           // Simulation time when the last one finished
+    double avg_elapsed_s;           // Mean time from first ACK to last DONE, as printed by app-io
+    double max_elapsed_s;
+    double wall_s;                  // Wall-clock time spent simulating
+    uint64_t migrations;            // Tasks idle CPUs stole from the ready queue of another CPU
+    metrics_summary_t metrics;      // Scheduler-side metrics of the run
+} batch_result_t;
+
+/**
+ * @brief Simulates a scenario in-process, without sockets and without sleeping.
+ *
+ * Each application goes through the same RUN/BLOCK cycle app-io drives over the socket,
+ * including the one-tick delay between a DONE and the next request. The scenario is not
+ * modified, so several threads may simulate the same scenario at once.
+ *
+ * @param scenario Scenario to simulate.
+ * @param policy Scheduling policy to evaluate.
+ * @param config Configuration used to create the policy's ready queues.
+ * @param num_cpus CPUs of the simulated machine, each with its own ready queue.
+ * @param report Where to print the app-io line of each finished application and the scheduler
+ *               metrics at the end, NULL for none.
+ * @param result Where to store the summary of the simulation.
+ * @return 0 on success, -1 on error.
+ */
+int simulate_batch(const batch_scenario_t *scenario, const scheduler_policy_t *policy,
+                   const policy_config_t *config, uint32_t num_cpus, FILE *report, batch_result_t *result);
+
+/**
+ * @brief Runs a whole scenario file in-process and prints the per-application lines and a summary.
+ *
+ * @param scenario_file Path to the scenario file.
+ * @param policy Scheduling policy to evaluate.
+ * @param config Configuration used to create the policy's ready queues.
+ * @param num_cpus CPUs of the simulated machine.
+ * @return 0 on success, -1 on error.
+ */
+int run_batch(const char *scenario_file, const scheduler_policy_t *policy, const policy_config_t *config,
+              uint32_t num_cpus);
+
+#endif //BATCH_H
@@ -0,0 +1,48 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "burst_queue.h"
+
+/**
+ * @brief Prints a binary burst file in the text format, one burst per line.
+ *
+ * The nice value and the pages are only written for the bursts that have them.
+ */
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argc > 3) {
+        printf("Usage: %s <burst-file.bin> [burst-file.csv]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    burst_reader_t reader;
+    if (burst_reader_open(&reader, argv[1]) < 0) return EXIT_FAILURE;
+
+    FILE *out = argc == 3 ? fopen(argv[2], "w") : stdout;
+    if (!out) {
+        perror("fopen");
+        burst_reader_close(&reader);
+        return EXIT_FAILURE;
+    }
+
+    burst_t burst;
+    int status;
+    fprintf(out, "#BurstTime(ms),BlockTime(ms),nice,pages\n");
+    while ((status = burst_reader_next(&reader, &burst)) > 0) {
+        fprintf(out, "%u,%u", burst.burst_time_ms, burst.block_time_ms);
+        if (burst.nice != 0 || burst.pages.count > 0) fprintf(out, ",%d", burst.nice);
+        if (burst.pages.count > 0) {
+            fputs(",[", out);
+            for (uint32_t i = 0; i < burst.pages.count; i++) {
+                fprintf(out, i == 0 ? "%u" : ",%u", burst.pages.ids[i]);
+            }
+            fputc(']', out);
+        }
+        fputc('\n', out);
+    }
+    if (fclose(out) != 0) {
+        perror("fclose");
+        status = -1;
+    }
+    burst_reader_close(&reader);
+    return status < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -3,119 +3,354 @@
 
 #include "burst_queue.h"
 
+#include <fcntl.h>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-#define MAX_LINE_LEN 1024
+/**
+ * @brief Parses a decimal integer in [p, end) without copying it.
+ * @return The first character after the number, or NULL if there is no valid number in [min, max].
+ */
+static const char* parse_number(const char* p, const char* end, long min, long max, long* value) {
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
 
-int parse_burst_line(const char* line, burst_t* burst) {
-    if (!line || !burst) return -1;
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+    if (p == end || !isdigit((unsigned char)*p)) return NULL;
 
-    char* line_copy = strdup(line);
-    if (!line_copy) return -1;
+    long v = 0;
+    while (p < end && isdigit((unsigned char)*p)) {
+        v = v * 10 + (*p++ - '0');
+        if (v > (long)INT_MAX + 1) return NULL;
+    }
+    if (negative) v = -v;
+    if (v < min || v > max) return NULL;
 
-    char* endptr;
-    char* token = strtok(line_copy, ",");
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    *value = v;
+    return p;
+}
 
-    // Parse required burst_time_ms
-    if (!token) {
-        fprintf(stderr, "Missing burst time\n");
-        free(line_copy);
-        return -1;
+/**
+ * @brief Parses one line of a burst file, <burst>[,<block>[,<nice>[,[<page>,...]]]], in place.
+ * @return NULL on success, or the name of the first invalid field.
+ */
+static const char* parse_burst_line(const char* p, const char* end, burst_t* burst) {
+    long value;
+
+    if (!(p = parse_number(p, end, 0, INT_MAX, &value))) return "burst time";
+    burst->burst_time_ms = (uint32_t)value;
+    if (p == end) return NULL;
+    if (*p++ != ',') return "burst time";
+
+    if (!(p = parse_number(p, end, 0, INT_MAX, &value))) return "block time";
+    burst->block_time_ms = (uint32_t)value;
+    if (p == end) return NULL;
+    if (*p++ != ',') return "block time";
+
+    if (!(p = parse_number(p, end, INT_MIN, INT_MAX, &value))) return "nice value";
+    burst->nice = (int)value;
+    if (p == end) return NULL;
+    if (*p++ != ',') return "nice value";
+
+    // Pages past MAX_PAGES are ignored
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    if (p == end || *p++ != '[') return "page list";
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    if (p < end && *p != ']') {
+        for (;;) {
+            if (!(p = parse_number(p, end, 0, INT_MAX, &value))) return "page number";
+            if (burst->pages.count < MAX_PAGES) burst->pages.ids[burst->pages.count++] = (uint32_t)value;
+            if (p == end || *p == ']') break;
+            if (*p++ != ',') return "page number";
+        }
     }
+    if (p == end || *p++ != ']') return "page list";
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    return p == end ? NULL : "page list";
+}
 
-    long burst_time = strtol(token, &endptr, 10);
-    if (*endptr != '\0' || burst_time < 0 || burst_time > INT_MAX) {
-        fprintf(stderr, "Invalid burst time: %s\n", token);
-        free(line_copy);
-        return -1;
+static uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+static int64_t unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+static uint8_t* put_varint(uint8_t* p, uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
     }
-    burst->burst_time_ms = (int)burst_time;
+    *p++ = (uint8_t)v;
+    return p;
+}
 
-    // Optional: block time
-    token = strtok(NULL, ",\n");
-    if (token) {
-        long block_time_ms = strtol(token, &endptr, 10);
-        if (*endptr != '\0' || block_time_ms < INT_MIN || block_time_ms > INT_MAX) {
-            fprintf(stderr, "Invalid block time value: %s\n", token);
-            free(line_copy);
-            return -1;
+/**
+ * @brief Decodes a varint of at most 10 bytes from [p, end).
+ * @return The first byte after it, or NULL if it is truncated or too long.
+ */
+static const uint8_t* get_varint(const uint8_t* p, const uint8_t* end, uint64_t* value) {
+    uint64_t v = 0;
+    for (unsigned shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t byte = *p++;
+        v |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = v;
+            return p;
         }
-        burst->block_time_ms = (int)block_time_ms;
     }
+    return NULL;
+}
 
-    // Optional: parse nice
-    token = strtok(NULL, ",\n");
-    if (token) {
-        long nice_value = strtol(token, &endptr, 10);
-        if (*endptr != '\0' || nice_value < INT_MIN || nice_value > INT_MAX) {
-            fprintf(stderr, "Invalid nice value: %s\n", token);
-            free(line_copy);
+static void put_le(uint8_t* p, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t get_le(const uint8_t* p, int bytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; i++) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+int burst_reader_open(burst_reader_t* reader, const char* filename) {
+    memset(reader, 0, sizeof(*reader));
+    reader->filename = filename;
+
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        close(fd);
+        return -1;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    reader->size = (size_t)st.st_size;
+    void* data = mmap(NULL, reader->size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+    madvise(data, reader->size, MADV_SEQUENTIAL);
+    reader->data = data;
+    reader->p = reader->data;
+    reader->end = reader->data + reader->size;
+
+    if (reader->size >= BURST_FILE_HEADER_SIZE && memcmp(reader->data, BURST_FILE_MAGIC, 4) == 0) {
+        uint32_t version = (uint32_t)get_le(reader->data + 4, 4);
+        if (version != BURST_FILE_VERSION) {
+            fprintf(stderr, "%s: unsupported binary workload version %u\n", filename, version);
+            burst_reader_close(reader);
             return -1;
         }
-        burst->nice = (int)nice_value;
-    }
-
-
-    // Optional: parse pages list
-    burst->pages.count = 0;
-    token = strtok(NULL, "[");
-    if (token) token = strtok(NULL, "]");
-    if (token) {
-        char* page_token = strtok(token, ",");
-        while (page_token &&  burst->pages.count< MAX_PAGES) {
-            long page = strtol(page_token, &endptr, 10);
-            if (*endptr != '\0' || page < 0 || page > INT_MAX) {
-                fprintf(stderr, "Invalid page number: %s\n", page_token);
-                free(line_copy);
-                return -1;
-            }
-            burst->pages.ids[burst->pages.count++] = (int)page;
-            page_token = strtok(NULL, ",");
-        }
+        reader->binary = 1;
+        reader->remaining = get_le(reader->data + 8, 8);
+        reader->max_bursts = reader->remaining;
+        reader->p += BURST_FILE_HEADER_SIZE;
+        return 0;
     }
 
-    free(line_copy);
+    // One burst per line at most
+    reader->max_bursts = 1;
+    for (const uint8_t* nl = reader->p; (nl = memchr(nl, '\n', (size_t)(reader->end - nl))) != NULL; ++nl) {
+        reader->max_bursts++;
+    }
     return 0;
 }
 
+static int next_binary_burst(burst_reader_t* reader, burst_t* burst) {
+    if (reader->remaining == 0) {
+        if (reader->p == reader->end) return 0;
+        fprintf(stderr, "%s: %zu bytes of garbage after the last burst\n",
+                reader->filename, (size_t)(reader->end - reader->p));
+        return -1;
+    }
 
-int read_queue_from_file(burst_queue_t* queue, const char* filename) {
-    if (!queue || !filename) return -1;
+    const uint8_t* p = reader->p;
+    const uint8_t* end = reader->end;
+    burst_t* previous = &reader->previous;
+    uint64_t v, flags;
+    int64_t value;
+
+    if (!(p = get_varint(p, end, &v))) goto corrupt;
+    value = (int64_t)previous->burst_time_ms + unzigzag(v);
+    if (value < 0 || value > INT_MAX) goto corrupt;
+    burst->burst_time_ms = (uint32_t)value;
+
+    if (!(p = get_varint(p, end, &v))) goto corrupt;
+    value = (int64_t)previous->block_time_ms + unzigzag(v);
+    if (value < 0 || value > INT_MAX) goto corrupt;
+    burst->block_time_ms = (uint32_t)value;
+
+    if (!(p = get_varint(p, end, &flags)) || (flags >> 1) > MAX_PAGES) goto corrupt;
+    burst->nice = 0;
+    if (flags & 1) {
+        if (!(p = get_varint(p, end, &v))) goto corrupt;
+        value = unzigzag(v);
+        if (value < INT_MIN || value > INT_MAX) goto corrupt;
+        burst->nice = (int)value;
+    }
+
+    burst->pages.count = (uint32_t)(flags >> 1);
+    value = 0;
+    for (uint32_t i = 0; i < burst->pages.count; i++) {
+        if (!(p = get_varint(p, end, &v))) goto corrupt;
+        value += unzigzag(v);
+        if (value < 0 || value > INT_MAX) goto corrupt;
+        burst->pages.ids[i] = (uint32_t)value;
+    }
+
+    previous->burst_time_ms = burst->burst_time_ms;
+    previous->block_time_ms = burst->block_time_ms;
+    reader->p = p;
+    reader->remaining--;
+    return 1;
 
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        perror("fopen");
+corrupt:
+    fprintf(stderr, "%s: corrupt burst at offset %zu\n", reader->filename, (size_t)(reader->p - reader->data));
+    return -1;
+}
+
+static int next_text_burst(burst_reader_t* reader, burst_t* burst) {
+    const char* end = (const char*)reader->end;
+    while ((const char*)reader->p < end) {
+        const char* line = (const char*)reader->p;
+        const char* eol = memchr(line, '\n', (size_t)(end - line));
+        if (!eol) eol = end;
+        reader->p = (const uint8_t*)(eol < end ? eol + 1 : end);
+        reader->line_number++;
+
+        // Trim leading whitespace and a trailing carriage return
+        while (line < eol && isspace((unsigned char)*line)) ++line;
+        if (eol > line && eol[-1] == '\r') --eol;
+        if (line == eol || *line == '#') continue;
+
+        burst->block_time_ms = 0;
+        burst->nice = 0;
+        burst->pages.count = 0;
+        const char* error = parse_burst_line(line, eol, burst);
+        if (!error) return 1;
+        fprintf(stderr, "%s:%u: invalid %s, skipping line: %.*s\n",
+                reader->filename, reader->line_number, error, (int)(eol - line), line);
+    }
+    return 0;
+}
+
+int burst_reader_next(burst_reader_t* reader, burst_t* burst) {
+    if (!reader->data) return 0;
+    return reader->binary ? next_binary_burst(reader, burst) : next_text_burst(reader, burst);
+}
+
+void burst_reader_close(burst_reader_t* reader) {
+    if (reader->data) munmap((void*)reader->data, reader->size);
+    reader->data = reader->p = reader->end = NULL;
+}
+
+int burst_writer_open(burst_writer_t* writer, FILE* file) {
+    memset(writer, 0, sizeof(*writer));
+    writer->file = file;
+
+    uint8_t header[BURST_FILE_HEADER_SIZE];
+    memcpy(header, BURST_FILE_MAGIC, 4);
+    put_le(header + 4, BURST_FILE_VERSION, 4);
+    put_le(header + 8, 0, 8);                   // Burst count, written by burst_writer_close
+    if (fwrite(header, sizeof(header), 1, file) != 1) {
+        perror("fwrite");
         return -1;
     }
+    return 0;
+}
 
-    char line[MAX_LINE_LEN];
-    int success_count = 0;
+int burst_writer_put(burst_writer_t* writer, const burst_t* burst) {
+    uint8_t record[BURST_RECORD_MAX_SIZE];
+    uint8_t* p = record;
+    burst_t* previous = &writer->previous;
+    uint32_t pages = burst->pages.count < MAX_PAGES ? burst->pages.count : MAX_PAGES;
 
-    while (fgets(line, sizeof(line), file)) {
-        // Trim leading whitespace
-        char* trimmed = line;
-        while (isspace(*trimmed)) ++trimmed;
-
-        if (*trimmed == '#' || *trimmed == '\0') continue;
-
-        burst_t burst = {0}; // Initialize burst structure
-        if (parse_burst_line(trimmed, &burst) == 0) {
-            if (enqueue_burst(queue, &burst)) {
-                success_count++;
-            } else {
-                fprintf(stderr, "Queue full or allocation failed\n");
-                break;
-            }
-        } else {
-            fprintf(stderr, "Skipping malformed line: %s", line);
-        }
+    p = put_varint(p, zigzag((int64_t)burst->burst_time_ms - previous->burst_time_ms));
+    p = put_varint(p, zigzag((int64_t)burst->block_time_ms - previous->block_time_ms));
+    p = put_varint(p, (uint64_t)pages << 1 | (burst->nice != 0));
+    if (burst->nice != 0) p = put_varint(p, zigzag(burst->nice));
+    int64_t page = 0;
+    for (uint32_t i = 0; i < pages; i++) {
+        p = put_varint(p, zigzag((int64_t)burst->pages.ids[i] - page));
+        page = burst->pages.ids[i];
+    }
+
+    if (fwrite(record, (size_t)(p - record), 1, writer->file) != 1) {
+        perror("fwrite");
+        return -1;
+    }
+    previous->burst_time_ms = burst->burst_time_ms;
+    previous->block_time_ms = burst->block_time_ms;
+    writer->count++;
+    return 0;
+}
+
+int burst_writer_close(burst_writer_t* writer) {
+    uint8_t count[8];
+    put_le(count, writer->count, 8);
+    if (fseek(writer->file, 8, SEEK_SET) < 0 || fwrite(count, sizeof(count), 1, writer->file) != 1) {
+        perror("burst_writer_close");
+        return -1;
+    }
+    return 0;
+}
+
+int read_bursts_from_file(const char* filename, burst_t** bursts) {
+    if (!filename || !bursts) return -1;
+    *bursts = NULL;
+
+    burst_reader_t reader;
+    if (burst_reader_open(&reader, filename) < 0) return -1;
+    if (reader.max_bursts == 0) return 0;
+
+    size_t capacity = reader.max_bursts < INT_MAX ? (size_t)reader.max_bursts : INT_MAX;
+    burst_t* array = malloc(capacity * sizeof(burst_t));
+    if (!array) {
+        fprintf(stderr, "%s: no memory for %zu bursts\n", filename, capacity);
+        burst_reader_close(&reader);
+        return -1;
     }
 
-    fclose(file);
-    return success_count;
+    int count = 0;
+    int status = 0;
+    while ((size_t)count < capacity && (status = burst_reader_next(&reader, &array[count])) > 0) count++;
+    burst_reader_close(&reader);
+
+    if (status < 0 || count == 0) {
+        free(array);
+        return status < 0 ? -1 : 0;
+    }
+    burst_t* shrunk = realloc(array, (size_t)count * sizeof(burst_t));
+    *bursts = shrunk ? shrunk : array;
+    return count;
+}
+
+int read_queue_from_file(burst_queue_t* queue, const char* filename) {
+    if (!queue || !filename) return -1;
+
+    burst_t* bursts;
+    int count = read_bursts_from_file(filename, &bursts);
+    int success_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (!enqueue_burst(queue, &bursts[i])) {
+            fprintf(stderr, "Queue full or allocation failed\n");
+            break;
+        }
+        success_count++;
+    }
+    free(bursts);
+    return count < 0 ? -1 : success_count;
 }
 
 
@@ -1,6 +1,10 @@
 #ifndef BURST_QUEUE_H
 #define BURST_QUEUE_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
 #include "msg.h"
 
 typedef struct {
@@ -21,6 +25,89 @@ typedef struct burst_queue_st  {
     burst_node_t* tail;
 } burst_queue_t;
 
+/*
+ * Binary burst files hold the same bursts as the text format in a few bytes each:
+ *
+ *     header:  "OSWL", version (u32), number of bursts (u64), all little-endian
+ *     burst:   varint zigzag(burst_ms - previous burst_ms)
+ *              varint zigzag(block_ms - previous block_ms)
+ *              varint (page count << 1) | (nice != 0)
+ *              [varint zigzag(nice)]                       if nice != 0
+ *              varint zigzag(page - previous page) ...      first page against 0
+ *
+ * A burst without pages or nice value usually takes 3 bytes instead of a text line, and no
+ * parsing. csv2bin and bin2csv convert between the two formats.
+ */
+#define BURST_FILE_MAGIC "OSWL"
+#define BURST_FILE_VERSION 1
+#define BURST_FILE_HEADER_SIZE 16
+#define BURST_RECORD_MAX_SIZE (10 * (4 + MAX_PAGES))      // Longest encoded burst
+
+// Streams the bursts of a text or binary burst file, mapped in memory
+typedef struct {
+    const char* filename;
+    const uint8_t* data;
+    size_t size;
+    const uint8_t* p;               // Next byte to decode
+    const uint8_t* end;
+    int binary;
+    uint64_t max_bursts;            // Upper bound of the number of bursts, to size arrays
+    uint64_t remaining;             // Binary: bursts not read yet
+    unsigned line_number;           // Text: line of the last burst
+    burst_t previous;               // Binary: base of the deltas
+} burst_reader_t;
+
+typedef struct {
+    FILE* file;
+    uint64_t count;
+    burst_t previous;
+} burst_writer_t;
+
+/**
+ * @brief Maps a burst file, text or binary (told apart by the magic number), for reading.
+ * @return 0 on success, -1 on error.
+ */
+int burst_reader_open(burst_reader_t* reader, const char* filename);
+
+/**
+ * @brief Reads the next burst. Malformed text lines are reported and skipped.
+ * @return 1 if a burst was read, 0 at the end of the file, -1 if a binary file is corrupt.
+ */
+int burst_reader_next(burst_reader_t* reader, burst_t* burst);
+
+void burst_reader_close(burst_reader_t* reader);
+
+/**
+ * @brief Starts a binary burst file in file, which must be seekable.
+ * @return 0 on success, -1 on error.
+ */
+int burst_writer_open(burst_writer_t* writer, FILE* file);
+
+/**
+ * @brief Appends a burst. Pages past MAX_PAGES are not written.
+ * @return 0 on success, -1 on error.
+ */
+int burst_writer_put(burst_writer_t* writer, const burst_t* burst);
+
+/**
+ * @brief Writes the number of bursts in the header. The file is left open.
+ * @return 0 on success, -1 on error.
+ */
+int burst_writer_close(burst_writer_t* writer);
+
+/**
+ * @brief Loads a burst file into one contiguous array.
+ *
+ * The file is memory-mapped and parsed in place. It may be binary, or text where each line is
+ *     <burst_ms>[,<block_ms>[,<nice>[,[<page>,...]]]]
+ * and lines starting with '#' are comments. Malformed lines are reported with their line
+ * number and skipped.
+ *
+ * @param bursts Set to the array, to be freed by the caller, or NULL if there is no burst.
+ * @return The number of bursts, or -1 on error.
+ */
+int read_bursts_from_file(const char* filename, burst_t** bursts);
+
 int read_queue_from_file(burst_queue_t* queue, const char* filename);
 int enqueue_burst(burst_queue_t* q, const burst_t* burst);
 burst_t* dequeue_burst(burst_queue_t* q);
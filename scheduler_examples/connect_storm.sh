@@ -0,0 +1,15 @@
+# This script starts the simulator and connects N applications to it at the same time.
+# Usage: ./connect_storm.sh [N] [scheduler options...], run from the build directory.
+# Example: ./connect_storm.sh 10000 -e -n 8 RR
+N=${1:-10000}
+[ $# -gt 0 ] && shift
+[ $# -eq 0 ] && set -- -e -n 8 RR
+SCENARIO=$(mktemp)
+printf '0,%s/../chrome.csv,%s\n' "$PWD" "$N" > "$SCENARIO"
+./scheduler "$@" > /dev/null &
+SCHEDULER=$!
+sleep 0.5
+./loadgen "$SCENARIO"
+kill -INT $SCHEDULER
+wait $SCHEDULER
+rm -f "$SCENARIO"
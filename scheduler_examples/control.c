@@ -0,0 +1,304 @@
+#define _GNU_SOURCE                 // accept4()
+#include "control.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "msg.h"
+
+static const char HELP[] =
+    "stats                 queues, running tasks, utilization and throughput\n"
+    "metrics               metrics of the tasks and bursts so far\n"
+    "pause                 stop the simulated clock\n"
+    "resume                start the simulated clock again\n"
+    "quantum [LEVEL] MS    set the time slice of RR, or of an MLFQ level (0 by default)\n"
+    "help                  this list\n";
+
+static int parse_uint32(const char *token, uint32_t *value) {
+    char *endptr;
+    unsigned long v = strtoul(token, &endptr, 10);
+    if (*token == '-' || endptr == token || *endptr != '\0' || v > UINT32_MAX) return -1;
+    *value = (uint32_t)v;
+    return 0;
+}
+
+/**
+ * @brief Parses a command line into the request.
+ * @return 0 for a command of the scheduler, 1 for help, -1 with *error set if the line is invalid.
+ */
+static int parse_command(char *line, control_request_t *request, const char **error) {
+    char *args[3];
+    int argc = 0;
+    char *saveptr;
+    for (char *token = strtok_r(line, " \t\r\n", &saveptr); token; token = strtok_r(NULL, " \t\r\n", &saveptr)) {
+        if (argc == 3) {
+            *error = "too many arguments";
+            return -1;
+        }
+        args[argc++] = token;
+    }
+    if (argc == 0) {
+        *error = "empty command, try help";
+        return -1;
+    }
+
+    if (strcmp(args[0], "help") == 0 && argc == 1) return 1;
+    if (strcmp(args[0], "stats") == 0 && argc == 1) {
+        request->command = CONTROL_STATS;
+    } else if (strcmp(args[0], "metrics") == 0 && argc == 1) {
+        request->command = CONTROL_METRICS;
+    } else if (strcmp(args[0], "pause") == 0 && argc == 1) {
+        request->command = CONTROL_PAUSE;
+    } else if (strcmp(args[0], "resume") == 0 && argc == 1) {
+        request->command = CONTROL_RESUME;
+    } else if (strcmp(args[0], "quantum") == 0 && argc >= 2) {
+        request->command = CONTROL_QUANTUM;
+        request->level = 0;
+        if ((argc == 3 && parse_uint32(args[1], &request->level) < 0) ||
+            parse_uint32(args[argc - 1], &request->quantum_ms) < 0 || request->quantum_ms == 0) {
+            *error = "usage: quantum [LEVEL] MS, with MS > 0";
+            return -1;
+        }
+    } else {
+        *error = "unknown command, try help";
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Reads the command line of a client, up to the first newline or the end of its input.
+ * @return 0 on success, -1 on error, timeout or an overlong line.
+ */
+static int read_line(int fd, char *line, size_t size) {
+    size_t len = 0;
+    while (len < size - 1) {
+        ssize_t n = read(fd, line + len, size - 1 - len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        len += (size_t)n;
+        if (memchr(line + len - (size_t)n, '\n', (size_t)n)) break;
+    }
+    line[len] = '\0';
+    return len > 0 && (len < size - 1 || memchr(line, '\n', len)) ? 0 : -1;
+}
+
+/**
+ * @brief Posts the request to the scheduler and waits for its answer.
+ * @return 0 once answered, -1 if the simulator is stopping.
+ */
+static int ask_scheduler(control_t *ctl) {
+    control_request_t *request = &ctl->request;
+    request->answered = 0;
+    request->error = NULL;
+    request->text = NULL;
+    request->text_len = 0;
+    if (io_post_control(ctl->io, request) < 0) return -1;
+
+    pthread_mutex_lock(&request->lock);
+    while (!request->answered && !atomic_load(&ctl->stop)) {
+        pthread_cond_wait(&request->answered_cond, &request->lock);
+    }
+    int answered = request->answered;
+    pthread_mutex_unlock(&request->lock);
+    return answered ? 0 : -1;
+}
+
+void control_answer(control_request_t *request) {
+    pthread_mutex_lock(&request->lock);
+    request->answered = 1;
+    pthread_cond_signal(&request->answered_cond);
+    pthread_mutex_unlock(&request->lock);
+}
+
+static void print_snapshot(const control_request_t *request, FILE *out) {
+    const control_snapshot_t *s = &request->snapshot;
+    uint32_t ready = 0, running = 0;
+    for (uint32_t l = 0; l < s->num_levels; l++) ready += s->ready[l];
+    for (uint32_t c = 0; c < s->num_cpus; c++) running += s->running[c] >= 0;
+
+    fprintf(out, "Time: %u ms, %s\n", request->time_ms, request->paused ? "paused" : "running");
+    fprintf(out, "Policy: %s on %u CPU%s", s->policy, s->num_cpus, s->num_cpus > 1 ? "s" : "");
+    if (s->quanta[0] != UINT32_MAX) {
+        fprintf(out, ", quantum");
+        for (uint32_t l = 0; l < s->num_levels; l++) fprintf(out, " %u", s->quanta[l]);
+        fprintf(out, " ms");
+    }
+    fprintf(out, "\nTasks: %u running, %u ready, %u blocked, %u waiting for a request\n",
+            running, ready, s->blocked, s->waiting);
+    if (s->num_levels > 1) {
+        fprintf(out, "Ready per level:");
+        for (uint32_t l = 0; l < s->num_levels; l++) fprintf(out, " %u", s->ready[l]);
+        fprintf(out, "\n");
+    }
+
+    // Utilization and throughput over the simulated time since the first RUN request
+    uint32_t span_ms = s->started ? request->time_ms - s->first_arrival_ms : 0;
+    uint64_t busy_ms = 0;
+    for (uint32_t c = 0; c < s->num_cpus; c++) {
+        busy_ms += s->busy_ms[c];
+        if (s->num_cpus < 2) continue;
+        fprintf(out, "CPU %u: ", c);
+        if (s->running[c] >= 0) {
+            fprintf(out, "PID %d", s->running[c]);
+        } else {
+            fprintf(out, "idle");
+        }
+        fprintf(out, ", %.1f%% busy\n", span_ms ? 100.0 * (double)s->busy_ms[c] / span_ms : 0.0);
+    }
+    if (s->num_cpus == 1) {
+        fprintf(out, "Running: ");
+        if (s->running[0] >= 0) {
+            fprintf(out, "PID %d\n", s->running[0]);
+        } else {
+            fprintf(out, "idle\n");
+        }
+    }
+    fprintf(out, "Utilization: %.1f%%\n",
+            span_ms ? 100.0 * (double)busy_ms / ((double)span_ms * s->num_cpus) : 0.0);
+    fprintf(out, "Throughput: %u bursts completed (%.2f/s), %u tasks exited, %u context switches\n",
+            s->bursts, span_ms ? s->bursts * 1000.0 / span_ms : 0.0, s->tasks, s->context_switches);
+    if (s->paced) {
+        fprintf(out, "Pacing: %llu ticks, %llu late\n", (unsigned long long)s->ticks, (unsigned long long)s->late);
+    }
+}
+
+static void print_answer(const control_request_t *request, FILE *out) {
+    if (request->error) {
+        fprintf(out, "Error: %s\n", request->error);
+        return;
+    }
+    switch (request->command) {
+        case CONTROL_STATS:
+            print_snapshot(request, out);
+            break;
+        case CONTROL_METRICS:
+            fwrite(request->text, 1, request->text_len, out);
+            break;
+        case CONTROL_PAUSE:
+            fprintf(out, "Paused at %u ms\n", request->time_ms);
+            break;
+        case CONTROL_RESUME:
+            fprintf(out, "Running at %u ms\n", request->time_ms);
+            break;
+        case CONTROL_QUANTUM:
+            fprintf(out, "Quantum of level %u set to %u ms at %u ms\n",
+                    request->level, request->quantum_ms, request->time_ms);
+            break;
+    }
+}
+
+/**
+ * @brief Accepts one connection, reads its command and writes the answer.
+ */
+static void serve_client(control_t *ctl) {
+    int fd = accept4(ctl->server_fd, NULL, NULL, SOCK_CLOEXEC);
+    if (fd < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED) {
+            perror("accept4: control");
+        }
+        return;
+    }
+    // The connection blocks, but never longer than CONTROL_TIMEOUT_MS
+    struct timeval tv = { .tv_sec = CONTROL_TIMEOUT_MS / 1000, .tv_usec = (CONTROL_TIMEOUT_MS % 1000) * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    FILE *out = fdopen(fd, "w");
+    if (!out) {
+        perror("fdopen: control");
+        close(fd);
+        return;
+    }
+
+    char line[CONTROL_LINE_MAX];
+    const char *error = NULL;
+    int ret = read_line(fd, line, sizeof(line));
+    if (ret < 0) {
+        error = "no command, or a line too long";
+    } else {
+        ret = parse_command(line, &ctl->request, &error);
+    }
+    if (ret < 0) {
+        fprintf(out, "Error: %s\n", error);
+    } else if (ret == 1) {
+        fputs(HELP, out);
+    } else if (ask_scheduler(ctl) == 0) {
+        print_answer(&ctl->request, out);
+        free(ctl->request.text);
+    }
+    fclose(out);
+}
+
+static void *control_main(void *arg) {
+    control_t *ctl = arg;
+    struct pollfd fds[2] = {
+        { .fd = ctl->server_fd, .events = POLLIN },
+        { .fd = ctl->wake_fd, .events = POLLIN },
+    };
+    while (!atomic_load(&ctl->stop)) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno != EINTR) perror("poll: control");
+            continue;
+        }
+        if (fds[0].revents & POLLIN) serve_client(ctl);
+    }
+    return NULL;
+}
+
+int control_start(control_t *ctl, io_thread_t *io) {
+    ctl->io = io;
+    atomic_init(&ctl->stop, 0);
+    ctl->server_fd = listen_socket(CONTROL_SOCKET_PATH, 16);
+    if (ctl->server_fd < 0) {
+        fprintf(stderr, "Failed to set up the control socket\n");
+        return -1;
+    }
+    ctl->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ctl->wake_fd < 0) {
+        perror("eventfd");
+        close(ctl->server_fd);
+        unlink(CONTROL_SOCKET_PATH);
+        return -1;
+    }
+    pthread_mutex_init(&ctl->request.lock, NULL);
+    pthread_cond_init(&ctl->request.answered_cond, NULL);
+
+    // The thread inherits a mask with every signal blocked
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    int err = pthread_create(&ctl->thread, NULL, control_main, ctl);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (err != 0) {
+        fprintf(stderr, "pthread_create: %s\n", strerror(err));
+        close(ctl->server_fd);
+        close(ctl->wake_fd);
+        unlink(CONTROL_SOCKET_PATH);
+        return -1;
+    }
+    return 0;
+}
+
+void control_stop(control_t *ctl) {
+    // Under the lock, so that a thread waiting for an answer cannot miss it
+    pthread_mutex_lock(&ctl->request.lock);
+    atomic_store(&ctl->stop, 1);
+    pthread_cond_broadcast(&ctl->request.answered_cond);
+    pthread_mutex_unlock(&ctl->request.lock);
+    uint64_t one = 1;
+    if (write(ctl->wake_fd, &one, sizeof(one)) < 0) perror("write: wake up control thread");
+    pthread_join(ctl->thread, NULL);
+
+    close(ctl->server_fd);
+    close(ctl->wake_fd);
+    unlink(CONTROL_SOCKET_PATH);
+    pthread_mutex_destroy(&ctl->request.lock);
+    pthread_cond_destroy(&ctl->request.answered_cond);
+}
@@ -0,0 +1,108 @@
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "io_thread.h"
+#include "machine.h"
+#include "mlfq.h"
+
+/*
+ * Control socket of a running simulator (CONTROL_SOCKET_PATH). An operator connects, writes one
+ * command line and reads the answer until the simulator closes the connection:
+ *
+ *   stats                 queues, running tasks, utilization and throughput
+ *   metrics               the metrics table printed at exit and on SIGUSR1
+ *   pause                 stop the simulated clock
+ *   resume                start it again
+ *   quantum [LEVEL] MS    time slice of RR, or of an MLFQ level (0 by default)
+ *   help
+ *
+ * Connections are served one at a time by a thread of their own. The command reaches the
+ * scheduling thread through the event queue of the I/O thread and is answered at the next
+ * tick: the scheduler copies a few counters into the request (or prints the metrics table for
+ * "metrics"), and the control thread formats the answer and writes it. A slow or stuck reader
+ * never delays a tick.
+ */
+
+#define CONTROL_LINE_MAX 256                // Longest command line
+#define CONTROL_TIMEOUT_MS 1000             // Time given to a reader or writer on the control socket
+
+typedef enum {
+    CONTROL_STATS = 0,
+    CONTROL_METRICS,
+    CONTROL_PAUSE,
+    CONTROL_RESUME,
+    CONTROL_QUANTUM,
+} control_command_en;
+
+// State of the simulator at one tick, filled in by the scheduler for CONTROL_STATS
+typedef struct {
+    const char *policy;
+    uint32_t num_cpus;
+    uint32_t num_levels;
+    uint32_t ready[MAX_MLFQ_LEVELS];        // Ready tasks per level
+    uint32_t quanta[MAX_MLFQ_LEVELS];       // Quantum of each level, UINT32_MAX if never preempted
+    uint32_t blocked;
+    uint32_t waiting;                       // Tasks in the command queue, waiting for a request
+    int32_t running[MAX_CPUS];              // PID on each CPU, -1 when idle
+    uint64_t busy_ms[MAX_CPUS];             // Including the slice of the running task
+    int started;                            // A task asked for the CPU
+    uint32_t first_arrival_ms;
+    uint32_t bursts;                        // Completed CPU bursts
+    uint32_t tasks;                         // Tasks that left the simulator
+    uint32_t context_switches;
+    int paced;
+    uint64_t ticks;                         // Paced ticks, and how many of them were late
+    uint64_t late;
+} control_snapshot_t;
+
+typedef struct control_request_st {
+    control_command_en command;
+    uint32_t level;                         // CONTROL_QUANTUM
+    uint32_t quantum_ms;
+
+    // Answer of the scheduler
+    uint32_t time_ms;                       // Simulation time when the command was handled
+    int paused;                             // Clock stopped afterwards
+    const char *error;                      // Why the command was refused, NULL on success
+    char *text;                             // CONTROL_METRICS, freed by the control thread
+    size_t text_len;
+    control_snapshot_t snapshot;            // CONTROL_STATS
+
+    pthread_mutex_t lock;
+    pthread_cond_t answered_cond;
+    int answered;
+} control_request_t;
+
+typedef struct {
+    io_thread_t *io;
+    int server_fd;
+    int wake_fd;                            // eventfd written by control_stop()
+    _Atomic uint32_t stop;
+    control_request_t request;              // The command being served
+    pthread_t thread;
+} control_t;
+
+/**
+ * @brief Listens on CONTROL_SOCKET_PATH and starts the control thread, which blocks every signal.
+ * @return 0 on success, -1 on error.
+ */
+int control_start(control_t *ctl, io_thread_t *io);
+
+/**
+ * @brief Stops the control thread, before the I/O thread, and removes the socket.
+ */
+void control_stop(control_t *ctl);
+
+/**
+ * @brief Hands the answer to an IO_EVENT_CONTROL back to the control thread.
+ *
+ * The scheduler fills in the answer fields of the request first, and must not touch it afterwards.
+ */
+void control_answer(control_request_t *request);
+
+#endif //CONTROL_H
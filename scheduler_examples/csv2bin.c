@@ -0,0 +1,46 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "burst_queue.h"
+
+/**
+ * @brief Converts a burst file to the binary format read by app-io and the scenario loader.
+ *
+ * The input may already be binary, which rewrites it in the current version.
+ */
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        printf("Usage: %s <burst-file.csv> <burst-file.bin>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    burst_reader_t reader;
+    if (burst_reader_open(&reader, argv[1]) < 0) return EXIT_FAILURE;
+
+    FILE *out = fopen(argv[2], "wb");
+    if (!out) {
+        perror("fopen");
+        burst_reader_close(&reader);
+        return EXIT_FAILURE;
+    }
+
+    burst_writer_t writer;
+    burst_t burst;
+    int status = burst_writer_open(&writer, out);
+    while (status == 0 && (status = burst_reader_next(&reader, &burst)) > 0) {
+        status = burst_writer_put(&writer, &burst);
+    }
+    if (status == 0) status = burst_writer_close(&writer);
+    if (fclose(out) != 0) {
+        perror("fclose");
+        status = -1;
+    }
+    burst_reader_close(&reader);
+
+    if (status < 0) {
+        remove(argv[2]);
+        return EXIT_FAILURE;
+    }
+    printf("%s: %llu bursts\n", argv[2], (unsigned long long)writer.count);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,89 @@
+#include "event_queue.h"
+
+#include <stdlib.h>
+
+#define EVENT_QUEUE_INITIAL_CAPACITY 64
+
+static int event_before(const event_t *a, const event_t *b) {
+    if (a->time_ms != b->time_ms) return a->time_ms < b->time_ms;
+    return a->seq < b->seq;
+}
+
+static void swap_events(event_t *a, event_t *b) {
+    event_t tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+/**
+ * @brief Adds an event to the queue.
+ *
+ * The heap grows on demand, so the only failure is running out of memory.
+ *
+ * @param q Pointer to the event queue.
+ * @param time_ms Simulation time at which the event fires.
+ * @param type Type of the event.
+ * @param pcb Task the event refers to.
+ * @return 1 on success, 0 on allocation failure.
+ */
+int push_event(event_queue_t *q, uint32_t time_ms, event_type_en type, pcb_t *pcb) {
+    if (q->count == q->capacity) {
+        uint32_t new_capacity = q->capacity ? q->capacity * 2 : EVENT_QUEUE_INITIAL_CAPACITY;
+        event_t *events = realloc(q->events, new_capacity * sizeof(event_t));
+        if (!events) return 0;
+        q->events = events;
+        q->capacity = new_capacity;
+    }
+
+    uint32_t i = q->count++;
+    q->events[i] = (event_t){ .time_ms = time_ms, .type = type, .pcb = pcb, .seq = q->next_seq++ };
+
+    // Sift up
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!event_before(&q->events[i], &q->events[parent])) break;
+        swap_events(&q->events[parent], &q->events[i]);
+        i = parent;
+    }
+    return 1;
+}
+
+/**
+ * @brief Removes the earliest event from the queue.
+ *
+ * @param q Pointer to the event queue.
+ * @param ev Where to store the removed event.
+ * @return 1 if an event was removed, 0 if the queue was empty.
+ */
+int pop_event(event_queue_t *q, event_t *ev) {
+    if (!q || q->count == 0) return 0;
+
+    *ev = q->events[0];
+    q->events[0] = q->events[--q->count];
+
+    // Sift down
+    uint32_t i = 0;
+    while (1) {
+        uint32_t left = 2 * i + 1;
+        uint32_t right = left + 1;
+        uint32_t smallest = i;
+        if (left < q->count && event_before(&q->events[left], &q->events[smallest])) smallest = left;
+        if (right < q->count && event_before(&q->events[right], &q->events[smallest])) smallest = right;
+        if (smallest == i) break;
+        swap_events(&q->events[i], &q->events[smallest]);
+        i = smallest;
+    }
+    return 1;
+}
+
+const event_t *peek_event(const event_queue_t *q) {
+    if (!q || q->count == 0) return NULL;
+    return &q->events[0];
+}
+
+void free_event_queue(event_queue_t *q) {
+    free(q->events);
+    q->events = NULL;
+    q->count = 0;
+    q->capacity = 0;
+}
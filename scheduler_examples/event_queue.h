@@ -0,0 +1,36 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <stdint.h>
+#include "queue.h"
+
+// Types of future events known to the discrete-event engine
+typedef enum {
+    EVENT_BURST_DONE = 0,       // Running task reaches the end of its CPU burst
+    EVENT_QUANTUM_EXPIRED,      // Running task exhausts its time slice
+    EVENT_BLOCK_EXPIRED,        // Blocked task finishes its I/O wait
+    EVENT_TASK_REQUEST,         // Task sends its next request (batch mode)
+} event_type_en;
+
+// A single future event, ordered by simulation time
+typedef struct {
+    uint32_t time_ms;           // Simulation time at which the event fires
+    event_type_en type;         // What happens at that time
+    pcb_t *pcb;                 // Task the event refers to
+    uint64_t seq;               // Insertion order, breaks ties between events of the same time
+} event_t;
+
+// Binary min-heap of events keyed on time_ms, events of the same time come out in insertion order
+typedef struct {
+    event_t *events;
+    uint32_t count;
+    uint32_t capacity;
+    uint64_t next_seq;
+} event_queue_t;
+
+int push_event(event_queue_t *q, uint32_t time_ms, event_type_en type, pcb_t *pcb);
+int pop_event(event_queue_t *q, event_t *ev);
+const event_t *peek_event(const event_queue_t *q);
+void free_event_queue(event_queue_t *q);
+
+#endif //EVENT_QUEUE_H
@@ -4,7 +4,28 @@
 #include <stdlib.h>
 
 #include "msg.h"
-#include <unistd.h>
+
+static void fifo_tick(void *rq, uint32_t current_time_ms, pcb_t **cpu_task) {
+    (void)rq;
+    if (*cpu_task) {
+
+        (*cpu_task)->ellapsed_time_ms += TICKS_MS;      // Add to the running time of the application/task, conta o tempo passado
+
+        if ((*cpu_task)->ellapsed_time_ms >= (*cpu_task)->time_ms)
+        {
+            // Task finished
+            // Send msg to application, main loop will move the task back to the command queue
+            finish_burst(*cpu_task, current_time_ms);
+            (*cpu_task) = NULL;
+        }
+
+    }
+}
+
+static pcb_t *fifo_pick(void *rq, uint32_t current_time_ms) {
+    (void)current_time_ms;
+    return dequeue_pcb((queue_t *)rq);   // Get next task from ready queue (dequeue from head)
+}
 
 /**
  * @brief First-In-First-Out (FIFO) scheduling algorithm.
@@ -20,37 +41,41 @@
  *                 to point to the next task to run.
  */
 void fifo_scheduler(uint32_t current_time_ms, queue_t *rq, pcb_t **cpu_task) {
-    if (*cpu_task) {
-
-        (*cpu_task)->ellapsed_time_ms += TICKS_MS;      // Add to the running time of the application/task, conta o tempo passado
-
-        if ((*cpu_task)->ellapsed_time_ms >= (*cpu_task)->time_ms)
-        {
+    fifo_tick(rq, current_time_ms, cpu_task);
 
-            // Task finished
-            // Send msg to application
-
-            msg_t msg = {
-                .pid = (*cpu_task)->pid,
-                .request = PROCESS_REQUEST_DONE,
-                .time_ms = current_time_ms
-            };
+    if (*cpu_task == NULL)
+    {            // If CPU is idle
+        *cpu_task = fifo_pick(rq, current_time_ms);
+    }
 
-            if (write((*cpu_task)->sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
-                perror("write");
-            }
+}
 
-            // Application finished and can be removed (this is FIFO after all)
-            free((*cpu_task));
-            (*cpu_task) = NULL;
+static void *fifo_init(const policy_config_t *config) {
+    (void)config;
+    return calloc(1, sizeof(queue_t));
+}
 
-        }
+static int fifo_enqueue(void *rq, pcb_t *task) {
+    return enqueue_pcb((queue_t *)rq, task);
+}
 
-    }
+static uint32_t fifo_ready_count(const void *rq) {
+    return ((const queue_t *)rq)->count;
+}
 
-    if (*cpu_task == NULL)
-    {            // If CPU is idle
-        *cpu_task = dequeue_pcb(rq);   // Get next task from ready queue (dequeue from head)
-    }
+static uint32_t fifo_quantum_ms(const void *rq, const pcb_t *task) {
+    (void)rq;
+    (void)task;
+    return UINT32_MAX;      // Never preempted
+}
 
-}
\ No newline at end of file
+const scheduler_policy_t fifo_policy = {
+    .name = "FIFO",
+    .init = fifo_init,
+    .enqueue = fifo_enqueue,
+    .tick = fifo_tick,
+    .pick = fifo_pick,
+    .ready_count = fifo_ready_count,
+    .quantum_ms = fifo_quantum_ms,
+    .destroy = free,
+};
@@ -1,8 +1,11 @@
 #ifndef FIFO_H
 #define FIFO_H
 
+#include "policy.h"
 #include "queue.h"
 
 void fifo_scheduler(uint32_t current_time_ms, queue_t *rq, pcb_t **cpu_task);
 
+extern const scheduler_policy_t fifo_policy;
+
 #endif //FIFO_H
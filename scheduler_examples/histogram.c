@@ -0,0 +1,65 @@
+#include "histogram.h"
+
+#include <time.h>
+
+#define SUB_BUCKETS (1u << HISTOGRAM_SUB_BITS)
+
+uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t bucket_of(uint64_t value) {
+    if (value < SUB_BUCKETS) return (uint32_t)value;
+    if (value >> HISTOGRAM_MAX_BITS) return HISTOGRAM_BUCKETS - 1;
+    uint32_t exponent = (uint32_t)(63 - __builtin_clzll(value)) - HISTOGRAM_SUB_BITS + 1;
+    return (exponent << HISTOGRAM_SUB_BITS) + (uint32_t)(value >> (exponent - 1)) - SUB_BUCKETS;
+}
+
+// Largest value of a bucket
+static uint64_t bucket_top(uint32_t bucket) {
+    uint32_t exponent = bucket >> HISTOGRAM_SUB_BITS;
+    if (exponent == 0) return bucket;
+    uint64_t base = (uint64_t)((bucket & (SUB_BUCKETS - 1)) + SUB_BUCKETS) << (exponent - 1);
+    return base + (1ull << (exponent - 1)) - 1;
+}
+
+void histogram_record(histogram_t *h, uint64_t value) {
+    h->counts[bucket_of(value)]++;
+    if (h->count == 0 || value < h->min) h->min = value;
+    if (value > h->max) h->max = value;
+    h->count++;
+    h->sum += value;
+}
+
+uint64_t histogram_percentile(const histogram_t *h, double percentile) {
+    if (h->count == 0) return 0;
+    uint64_t rank = (uint64_t)(percentile / 100.0 * (double)h->count + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank >= h->count) return h->max;
+
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < HISTOGRAM_BUCKETS; b++) {
+        seen += h->counts[b];
+        if (seen >= rank) {
+            uint64_t top = bucket_top(b);
+            if (top > h->max) top = h->max;
+            return top < h->min ? h->min : top;
+        }
+    }
+    return h->max;
+}
+
+void print_histogram_header(FILE *out, const char *title) {
+    fprintf(out, "%-30s %8s %10s %9s %9s %9s %9s %9s\n", title, "count", "mean", "p50", "p90", "p99", "p99.9", "max");
+}
+
+void print_histogram_line(FILE *out, const char *name, const histogram_t *h) {
+    if (h->count == 0) return;
+    fprintf(out, "  %-28s %8llu %10.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", name, (unsigned long long)h->count,
+            (double)h->sum / (double)h->count / 1000.0,
+            (double)histogram_percentile(h, 50) / 1000.0, (double)histogram_percentile(h, 90) / 1000.0,
+            (double)histogram_percentile(h, 99) / 1000.0, (double)histogram_percentile(h, 99.9) / 1000.0,
+            (double)h->max / 1000.0);
+}
@@ -0,0 +1,49 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define HISTOGRAM_SUB_BITS 5        // 32 linear sub-buckets per power of two: values within 1/32
+#define HISTOGRAM_MAX_BITS 40       // Values up to 2^40 ns (18 minutes), larger ones are clamped
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS + 1) << HISTOGRAM_SUB_BITS)
+
+/*
+ * Log-bucketed latency histogram in the style of HdrHistogram: the values below 2^SUB_BITS have a
+ * bucket each, and every power of two above is split into 2^SUB_BITS equal buckets, so a value is
+ * known to about 3% whatever its magnitude. Recording is a few instructions and never allocates,
+ * which keeps it cheap enough for every message on the hot path. A histogram belongs to a single
+ * thread.
+ */
+typedef struct {
+    uint64_t counts[HISTOGRAM_BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+} histogram_t;
+
+/**
+ * @brief Current CLOCK_MONOTONIC time in nanoseconds, the clock of every latency histogram.
+ */
+uint64_t monotonic_ns(void);
+
+void histogram_record(histogram_t *h, uint64_t value);
+
+/**
+ * @brief Value below which the given percentage of the recorded values fall, to bucket precision.
+ * @return 0 if the histogram is empty.
+ */
+uint64_t histogram_percentile(const histogram_t *h, double percentile);
+
+/**
+ * @brief Prints the title and the column names of the rows printed by print_histogram_line().
+ */
+void print_histogram_header(FILE *out, const char *title);
+
+/**
+ * @brief Prints the count, mean, p50, p90, p99, p99.9 and max of a histogram of nanoseconds, in microseconds.
+ */
+void print_histogram_line(FILE *out, const char *name, const histogram_t *h);
+
+#endif //HISTOGRAM_H
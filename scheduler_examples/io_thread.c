@@ -0,0 +1,676 @@
+#define _GNU_SOURCE                 // accept4()
+#include "io_thread.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "debug.h"
+
+#define EPOLL_BATCH 256             // Ready connections handled per epoll_wait call
+#define ACCEPT_BATCH 256            // Connections accepted before serving the others again
+
+_Static_assert((IO_QUEUE_SIZE & (IO_QUEUE_SIZE - 1)) == 0, "IO_QUEUE_SIZE must be a power of two");
+
+static int futex_wait(_Atomic uint32_t *word, uint32_t expected, int timeout_ms) {
+    struct timespec ts, *tsp = NULL;
+    if (timeout_ms >= 0) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+        tsp = &ts;
+    }
+    return (int)syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, expected, tsp, NULL, 0);
+}
+
+static void futex_wake(_Atomic uint32_t *word) {
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+/*
+ * Event queue: the bounded MPSC queue of Dmitry Vyukov. Cell i holds seq = i while free for the
+ * producer that claims position i, seq = i + 1 once the event is written, and seq = i + size after
+ * the consumer took it, when it is free for position i + size. Producers claim positions with a
+ * CAS on tail; the consumer owns head.
+ */
+static void event_queue_init(io_event_queue_t *q) {
+    for (uint64_t i = 0; i < IO_QUEUE_SIZE; i++) {
+        atomic_init(&q->cells[i].seq, i);
+    }
+    atomic_init(&q->tail, 0);
+    q->head = 0;
+}
+
+static int event_queue_push(io_event_queue_t *q, const io_event_t *event) {
+    uint64_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    io_event_cell_t *cell;
+    for (;;) {
+        cell = &q->cells[pos & (IO_QUEUE_SIZE - 1)];
+        uint64_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        int64_t diff = (int64_t)(seq - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return 0;                       // Full
+        } else {
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        }
+    }
+    cell->event = *event;
+    // Sequentially consistent, so that either the scheduler sees the event or we see it waiting
+    atomic_store(&cell->seq, pos + 1);
+    return 1;
+}
+
+static int event_queue_empty(io_event_queue_t *q) {
+    return atomic_load(&q->cells[q->head & (IO_QUEUE_SIZE - 1)].seq) != q->head + 1;
+}
+
+static int event_queue_pop(io_event_queue_t *q, io_event_t *event) {
+    io_event_cell_t *cell = &q->cells[q->head & (IO_QUEUE_SIZE - 1)];
+    if (atomic_load_explicit(&cell->seq, memory_order_acquire) != q->head + 1) return 0;
+    *event = cell->event;
+    atomic_store_explicit(&cell->seq, q->head + IO_QUEUE_SIZE, memory_order_release);
+    q->head++;
+    return 1;
+}
+
+/*
+ * Command queue: a plain SPSC ring, head and tail count commands and wrap around.
+ */
+static int command_queue_push(io_command_queue_t *q, const io_command_t *command) {
+    uint64_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&q->tail, memory_order_acquire) == IO_QUEUE_SIZE) return 0;
+    q->commands[head & (IO_QUEUE_SIZE - 1)] = *command;
+    atomic_store(&q->head, head + 1);       // Sequentially consistent, see event_queue_push()
+    return 1;
+}
+
+static int command_queue_empty(io_command_queue_t *q) {
+    return atomic_load(&q->head) == atomic_load_explicit(&q->tail, memory_order_relaxed);
+}
+
+static int command_queue_pop(io_command_queue_t *q, io_command_t *command) {
+    uint64_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    if (atomic_load_explicit(&q->head, memory_order_acquire) == tail) return 0;
+    *command = q->commands[tail & (IO_QUEUE_SIZE - 1)];
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+static void process_commands(io_thread_t *io);
+
+static void wake_scheduler(io_thread_t *io) {
+    if (atomic_load(&io->sched_waiting)) {
+        atomic_fetch_add(&io->events_posted, 1);
+        futex_wake(&io->events_posted);
+    }
+}
+
+/**
+ * @brief Hands an event to the scheduler, waking it up if it sleeps.
+ *
+ * When the queue is full the I/O thread keeps executing commands while it waits for room, so
+ * a scheduler waiting for room in the command queue can always make progress.
+ */
+static void post_event(io_thread_t *io, io_event_en type, pcb_t *pcb, const msg_t *msg, burst_msg_t *workload) {
+    io_event_t event = { .type = type, .pcb = pcb, .workload = workload, .received_ns = monotonic_ns() };
+    if (msg) event.msg = *msg;
+    while (!event_queue_push(&io->events, &event)) {
+        if (atomic_load(&io->stop)) {
+            free(workload);                 // The scheduler is gone, nobody will take the event
+            return;
+        }
+        process_commands(io);
+        sched_yield();
+    }
+    wake_scheduler(io);
+}
+
+int io_post_control(io_thread_t *io, struct control_request_st *request) {
+    io_event_t event = { .type = IO_EVENT_CONTROL, .control = request, .received_ns = monotonic_ns() };
+    // The event queue takes several producers; only the I/O thread may run the commands meanwhile
+    while (!event_queue_push(&io->events, &event)) {
+        if (atomic_load(&io->stop)) return -1;
+        sched_yield();
+    }
+    wake_scheduler(io);
+    return 0;
+}
+
+/**
+ * @brief Hands a command to the I/O thread, waking it up if it sleeps.
+ */
+static void post_command(io_thread_t *io, const io_command_t *command) {
+    while (!command_queue_push(&io->commands, command)) {
+        sched_yield();                      // The I/O thread is awake, it is draining the queue
+    }
+    if (atomic_load(&io->io_waiting)) {
+        atomic_store(&io->io_waiting, 0);   // One wake-up per sleep is enough
+        if (io->shm_region) {
+            shm_server_notify(io->shm_region);
+        } else {
+            uint64_t one = 1;
+            if (write(io->wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+                perror("write: wake up I/O thread");
+            }
+        }
+    }
+}
+
+int io_poll_event(io_thread_t *io, io_event_t *event) {
+    return event_queue_pop(&io->events, event);
+}
+
+int io_wait_event(io_thread_t *io, int timeout_ms) {
+    if (!event_queue_empty(&io->events)) return 1;
+    if (timeout_ms == 0) return 0;
+
+    uint32_t posted = atomic_load(&io->events_posted);
+    atomic_store(&io->sched_waiting, 1);
+    int ret = 1;
+    if (event_queue_empty(&io->events)) {
+        if (futex_wait(&io->events_posted, posted, timeout_ms) < 0 && errno == ETIMEDOUT) {
+            ret = !event_queue_empty(&io->events);
+        }
+    }
+    atomic_store(&io->sched_waiting, 0);
+    return ret;
+}
+
+void io_send(io_thread_t *io, pcb_t *pcb, process_request_t request, uint32_t time_ms,
+             io_latency_en latency, uint64_t since_ns) {
+    io_command_t command = {
+        .type = IO_COMMAND_SEND,
+        .pcb = pcb,
+        .msg = { .pid = pcb->pid, .request = request, .time_ms = time_ms },
+        .latency = latency,
+        .since_ns = since_ns,
+    };
+    post_command(io, &command);
+}
+
+void io_watch(io_thread_t *io, pcb_t *pcb) {
+    post_command(io, &(io_command_t){ .type = IO_COMMAND_WATCH, .pcb = pcb });
+}
+
+void io_close(io_thread_t *io, pcb_t *pcb) {
+    post_command(io, &(io_command_t){ .type = IO_COMMAND_CLOSE, .pcb = pcb });
+}
+
+void print_io_latency(const io_thread_t *io, FILE *out) {
+    static const char *const names[IO_LATENCY_COUNT] = {
+        [IO_LATENCY_RUN_ACK] = "RUN received to ACK sent",
+        [IO_LATENCY_BLOCK_ACK] = "BLOCK received to ACK sent",
+        [IO_LATENCY_SUBMIT_ACK] = "SUBMIT received to ACK sent",
+        [IO_LATENCY_RUN_DONE] = "RUN DONE due to sent",
+        [IO_LATENCY_BLOCK_DONE] = "BLOCK DONE due to sent",
+        [IO_LATENCY_SUBMIT_DONE] = "SUBMIT DONE due to sent",
+    };
+    for (int i = 0; i < IO_LATENCY_COUNT; i++) {
+        print_histogram_line(out, names[i], &io->latency[i]);
+    }
+}
+
+/**
+ * @brief Reads what a client sent so far without blocking, with the semantics of read().
+ */
+static ssize_t recv_msg(io_thread_t *io, const pcb_t *pcb, void *buf, size_t len) {
+    if (!io->shm_region) return read(pcb->sockfd, buf, len);
+
+    shm_slot_t *slot = &io->shm_region->slot[pcb->sockfd];
+    size_t n = shm_ring_read(&slot->to_sim, buf, len);
+    if (n == 0) {
+        if (atomic_load(&slot->state) != SHM_SLOT_OPEN) return 0;
+        errno = EAGAIN;
+        return -1;
+    }
+    return (ssize_t)n;
+}
+
+/**
+ * @brief Re-arms a client so that its next message is reported.
+ *
+ * Socket clients are registered with EPOLLONESHOT: after a message is reported the connection
+ * stays silent until the scheduler asks for the next one. Shared-memory clients flag their slot on
+ * every write, and flags seen while the slot was not watched are dropped, so the slot is looked at
+ * again if the application already wrote something.
+ */
+static void watch_client(io_thread_t *io, pcb_t *pcb) {
+    if (io->shm_region) {
+        uint32_t index = pcb->sockfd;
+        shm_slot_t *slot = &io->shm_region->slot[index];
+        io->shm_watched[index / 64] |= 1ull << (index % 64);
+        if (shm_ring_available(&slot->to_sim) > 0 || atomic_load(&slot->state) != SHM_SLOT_OPEN) {
+            io->shm_pending[index / 64] |= 1ull << (index % 64);
+        }
+        return;
+    }
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLONESHOT, .data.ptr = pcb };
+    if (epoll_ctl(io->epoll_fd, EPOLL_CTL_MOD, (int)pcb->sockfd, &ev) < 0) {
+        perror("epoll_ctl: rearm client");
+    }
+}
+
+/*
+ * A request that arrives in pieces (a message split by the transport, or the bursts of a large
+ * SUBMIT) is kept with the task until the rest comes in, so the I/O thread never waits for one
+ * client while the others have something to say.
+ */
+typedef struct io_partial_st {
+    msg_t msg;
+    size_t msg_len;                         // Bytes of msg read so far
+    burst_msg_t *workload;                  // Bursts of a SUBMIT, allocated once msg is complete
+    size_t workload_len;                    // Bytes of workload read so far
+} io_partial_t;
+
+static void free_partial(pcb_t *pcb) {
+    if (!pcb->partial) return;
+    free(pcb->partial->workload);
+    free(pcb->partial);
+    pcb->partial = NULL;
+}
+
+/**
+ * @brief Reads up to the end of buf without blocking.
+ * @return 1 once buf is full, 0 if the client has nothing more for now, -1 on EOF or error.
+ */
+static int read_some(io_thread_t *io, const pcb_t *pcb, void *buf, size_t len, size_t *done) {
+    while (*done < len) {
+        ssize_t n = recv_msg(io, pcb, (char *)buf + *done, len - *done);
+        if (n > 0) {
+            *done += (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+        if (n < 0) {
+            perror("read");
+        } else {
+            DBG("Connection closed by remote host\n");
+        }
+        return -1;
+    }
+    return 1;
+}
+
+/**
+ * @brief Reads the request of a client that has something for the scheduler and hands it over.
+ *
+ * What is missing of the request is read the next time the client is ready.
+ */
+static void read_client_message(io_thread_t *io, pcb_t *pcb) {
+    io_partial_t first = {0};
+    io_partial_t *p = pcb->partial ? pcb->partial : &first;
+
+    int ret = read_some(io, pcb, &p->msg, sizeof(msg_t), &p->msg_len);
+    if (ret > 0 && p->msg.request == PROCESS_REQUEST_SUBMIT) {
+        if (!p->workload) {
+            if (p->msg.time_ms == 0 || p->msg.time_ms > MAX_SUBMIT_BURSTS ||
+                !(p->workload = malloc((size_t)p->msg.time_ms * sizeof(burst_msg_t)))) {
+                fprintf(stderr, "Invalid SUBMIT of %u bursts from process %d, closing the connection\n",
+                        p->msg.time_ms, p->msg.pid);
+                ret = -1;
+            }
+        }
+        if (ret > 0) {
+            ret = read_some(io, pcb, p->workload, (size_t)p->msg.time_ms * sizeof(burst_msg_t), &p->workload_len);
+        }
+    }
+
+    if (ret == 0) {
+        // Keep what was read with the task until the rest arrives
+        if (p == &first && first.msg_len > 0) {
+            if (!(pcb->partial = malloc(sizeof(io_partial_t)))) {
+                perror("malloc");
+                free(first.workload);
+                post_event(io, IO_EVENT_CLOSED, pcb, NULL, NULL);
+                return;
+            }
+            *pcb->partial = first;
+        }
+        watch_client(io, pcb);
+    } else if (ret < 0) {
+        if (p == &first) {
+            free(first.workload);
+        } else {
+            free_partial(pcb);
+        }
+        post_event(io, IO_EVENT_CLOSED, pcb, NULL, NULL);
+    } else {
+        msg_t msg = p->msg;
+        burst_msg_t *workload = p->workload;
+        if (p != &first) {
+            free(pcb->partial);
+            pcb->partial = NULL;
+        }
+        post_event(io, IO_EVENT_MESSAGE, pcb, &msg, workload);
+    }
+}
+
+/**
+ * @brief Refuses a pending connection when the process is out of file descriptors.
+ *
+ * The listening socket is level-triggered, so a connection left in the backlog would wake the
+ * I/O thread again and again. The reserve descriptor is given up for a moment to accept the
+ * connection and close it at once: the application sees EOF instead of hanging in the backlog.
+ */
+static void shed_connection(io_thread_t *io) {
+    if (io->reserve_fd >= 0) {
+        close(io->reserve_fd);
+        io->reserve_fd = -1;
+    }
+    int fd = accept4(io->server_fd, NULL, NULL, SOCK_CLOEXEC);
+    if (fd >= 0) {
+        close(fd);
+        io->shed++;
+        if (!io->shedding) {
+            fprintf(stderr, "Out of file descriptors, refusing new applications (ulimit -n)\n");
+        }
+        io->shedding = 1;
+    }
+    io->reserve_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+}
+
+static void accept_new_clients(io_thread_t *io) {
+    for (int i = 0; i < ACCEPT_BATCH; i++) {
+        int client_fd = accept4(io->server_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (errno == EMFILE || errno == ENFILE) {
+                shed_connection(io);
+                continue;
+            }
+            if (errno == EINTR)        continue;
+            if (errno == ECONNABORTED) continue;
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                perror("accept4");
+            }
+            return;
+        }
+        io->shedding = 0;
+        DBG("[Scheduler] New client connected: fd=%d\n", client_fd);
+        pcb_t *pcb = new_pcb(++io->next_pid, client_fd, 0);
+        if (!pcb) {
+            close(client_fd);
+            continue;
+        }
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLONESHOT, .data.ptr = pcb };
+        if (epoll_ctl(io->epoll_fd, EPOLL_CTL_ADD, client_fd, &ev) < 0) {
+            perror("epoll_ctl: add client");
+            close(client_fd);
+            free(pcb);
+            continue;
+        }
+        post_event(io, IO_EVENT_CONNECTED, pcb, NULL, NULL);
+    }
+}
+
+/**
+ * @brief Registers the application that claimed a slot of the shared memory segment.
+ *
+ * A slot flagged without a task of its own is either new, or one the simulator dropped whose
+ * application now closed it or died: that one is freed.
+ */
+static void accept_shm_client(io_thread_t *io, uint32_t index) {
+    uint32_t state = atomic_load(&io->shm_region->slot[index].state);
+    if (state == SHM_SLOT_FREE) return;
+    if (state != SHM_SLOT_OPEN) {
+        shm_server_release(io->shm_region, index);
+        return;
+    }
+    DBG("[Scheduler] New client connected: slot=%u\n", index);
+    pcb_t *pcb = new_pcb(++io->next_pid, index, 0);
+    if (!pcb) {
+        shm_server_release(io->shm_region, index);
+        return;
+    }
+    io->shm_clients[index] = pcb;
+    io->shm_watched[index / 64] |= 1ull << (index % 64);
+    post_event(io, IO_EVENT_CONNECTED, pcb, NULL, NULL);
+}
+
+static void send_client_msg(io_thread_t *io, const pcb_t *pcb, const msg_t *msg) {
+    if (io->shm_region) {
+        if (shm_ring_write(&io->shm_region->slot[pcb->sockfd].to_app, msg, sizeof(msg_t)) != sizeof(msg_t)) {
+            fprintf(stderr, "Ring of process %d is full, %s lost\n", msg->pid, PROCESS_REQUEST_STRINGS[msg->request]);
+        }
+        return;
+    }
+    if (write(pcb->sockfd, msg, sizeof(msg_t)) != sizeof(msg_t)) {
+        perror("write");
+    }
+}
+
+static void close_client(io_thread_t *io, pcb_t *pcb) {
+    free_partial(pcb);
+    if (io->shm_region) {
+        uint32_t index = pcb->sockfd;
+        io->shm_clients[index] = NULL;
+        io->shm_watched[index / 64] &= ~(1ull << (index % 64));
+        shm_server_release(io->shm_region, index);
+    } else {
+        close(pcb->sockfd);     // Also drops the epoll registration
+    }
+    free(pcb);
+}
+
+static void process_commands(io_thread_t *io) {
+    io_command_t command;
+    while (command_queue_pop(&io->commands, &command)) {
+        switch (command.type) {
+            case IO_COMMAND_SEND:
+                send_client_msg(io, command.pcb, &command.msg);
+                histogram_record(&io->latency[command.latency], monotonic_ns() - command.since_ns);
+                break;
+            case IO_COMMAND_WATCH:
+                watch_client(io, command.pcb);
+                break;
+            case IO_COMMAND_CLOSE:
+                close_client(io, command.pcb);
+                break;
+        }
+    }
+}
+
+/**
+ * @brief Reads the requests of the flagged shared-memory slots that are watched.
+ * @return 1 if some slot is still pending, 0 otherwise.
+ */
+static int process_shm_slots(io_thread_t *io) {
+    shm_server_collect(io->shm_region, io->shm_pending);
+    for (uint32_t w = 0; w < SHM_MAX_CLIENTS / 64; w++) {
+        uint64_t bits = io->shm_pending[w];
+        io->shm_pending[w] = 0;
+        while (bits) {
+            uint32_t index = w * 64 + (uint32_t)__builtin_ctzll(bits);
+            uint64_t bit = 1ull << (index % 64);
+            bits &= bits - 1;
+            if (!io->shm_clients[index]) {
+                accept_shm_client(io, index);
+                if (!io->shm_clients[index]) continue;
+            }
+            // Flags of unwatched slots are dropped, watch_client() looks at the slot again later
+            if (!(io->shm_watched[w] & bit)) continue;
+            io->shm_watched[w] &= ~bit;
+            read_client_message(io, io->shm_clients[index]);
+        }
+    }
+    for (uint32_t w = 0; w < SHM_MAX_CLIENTS / 64; w++) {
+        if (io->shm_pending[w]) return 1;
+    }
+    return 0;
+}
+
+static void run_shm(io_thread_t *io) {
+    uint64_t next_reap_ns = monotonic_ns() + SHM_REAP_MS * 1000000ull;
+    while (!atomic_load(&io->stop)) {
+        process_commands(io);
+        // Applications that died holding a slot never close it, their slots show up as closed
+        if (monotonic_ns() >= next_reap_ns) {
+            shm_server_reap(io->shm_region, io->shm_pending);
+            next_reap_ns = monotonic_ns() + SHM_REAP_MS * 1000000ull;
+        }
+        if (process_shm_slots(io)) continue;
+
+        // The scheduler wakes us up through shm_server_notify() once it sees io_waiting
+        atomic_store(&io->io_waiting, 1);
+        if (command_queue_empty(&io->commands) && !atomic_load(&io->stop)) {
+            shm_server_wait(io->shm_region, SHM_REAP_MS);
+        }
+        atomic_store(&io->io_waiting, 0);
+    }
+}
+
+static void run_socket(io_thread_t *io) {
+    struct epoll_event ready[EPOLL_BATCH];
+    int nready = 0;
+    while (!atomic_load(&io->stop)) {
+        process_commands(io);
+
+        int timeout_ms = 0;
+        if (nready < EPOLL_BATCH) {
+            atomic_store(&io->io_waiting, 1);
+            if (command_queue_empty(&io->commands) && !atomic_load(&io->stop)) timeout_ms = -1;
+        }
+        nready = epoll_wait(io->epoll_fd, ready, EPOLL_BATCH, timeout_ms);
+        atomic_store(&io->io_waiting, 0);
+        if (nready < 0) {
+            if (errno != EINTR) perror("epoll_wait");
+            nready = 0;
+            continue;
+        }
+        for (int i = 0; i < nready; i++) {
+            pcb_t *pcb = ready[i].data.ptr;
+            if (pcb == NULL) {
+                accept_new_clients(io);
+            } else if (ready[i].data.ptr == &io->wake_fd) {
+                uint64_t count;
+                if (read(io->wake_fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+                    perror("read: I/O thread wake-up");
+                }
+            } else {
+                read_client_message(io, pcb);
+            }
+        }
+    }
+}
+
+static void *io_thread_main(void *arg) {
+    io_thread_t *io = arg;
+    if (io->shm_region) {
+        run_shm(io);
+    } else {
+        run_socket(io);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Closes whatever part of the transport is set up.
+ */
+static void close_transport(io_thread_t *io) {
+    if (io->shm_region) {
+        shm_server_close(io->shm_region);
+        io->shm_region = NULL;
+    }
+    if (io->server_fd >= 0) {
+        close(io->server_fd);
+        unlink(SOCKET_PATH);
+    }
+    if (io->epoll_fd >= 0) close(io->epoll_fd);
+    if (io->wake_fd >= 0) close(io->wake_fd);
+    if (io->reserve_fd >= 0) close(io->reserve_fd);
+    io->server_fd = io->epoll_fd = io->wake_fd = io->reserve_fd = -1;
+}
+
+int io_thread_start(io_thread_t *io, transport_en transport, int backlog) {
+    event_queue_init(&io->events);
+    atomic_init(&io->commands.head, 0);
+    atomic_init(&io->commands.tail, 0);
+    atomic_init(&io->events_posted, 0);
+    atomic_init(&io->sched_waiting, 0);
+    atomic_init(&io->io_waiting, 0);
+    atomic_init(&io->stop, 0);
+    io->transport = transport;
+    io->server_fd = io->epoll_fd = io->wake_fd = io->reserve_fd = -1;
+    io->shed = 0;
+    io->shedding = 0;
+    io->shm_region = NULL;
+    memset(io->shm_clients, 0, sizeof(io->shm_clients));
+    memset(io->shm_pending, 0, sizeof(io->shm_pending));
+    memset(io->shm_watched, 0, sizeof(io->shm_watched));
+    io->next_pid = 0;
+    memset(io->latency, 0, sizeof(io->latency));
+
+    if (transport == TRANSPORT_SHM) {
+        io->shm_region = shm_server_open();
+        if (!io->shm_region) {
+            fprintf(stderr, "Failed to set up shared memory\n");
+            return -1;
+        }
+    } else {
+        io->server_fd = listen_socket(SOCKET_PATH, backlog);
+        if (io->server_fd < 0) {
+            fprintf(stderr, "Failed to set up server socket\n");
+            return -1;
+        }
+        io->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        io->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        io->reserve_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        if (io->epoll_fd < 0 || io->wake_fd < 0 || io->reserve_fd < 0) {
+            perror(io->epoll_fd < 0 ? "epoll_create1" : io->wake_fd < 0 ? "eventfd" : "open /dev/null");
+            close_transport(io);
+            return -1;
+        }
+        struct epoll_event server_ev = { .events = EPOLLIN, .data.ptr = NULL };
+        struct epoll_event wake_ev = { .events = EPOLLIN, .data.ptr = &io->wake_fd };
+        if (epoll_ctl(io->epoll_fd, EPOLL_CTL_ADD, io->server_fd, &server_ev) < 0 ||
+            epoll_ctl(io->epoll_fd, EPOLL_CTL_ADD, io->wake_fd, &wake_ev) < 0) {
+            perror("epoll_ctl: add server");
+            close_transport(io);
+            return -1;
+        }
+    }
+
+    // The thread inherits a mask with every signal blocked
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    int err = pthread_create(&io->thread, NULL, io_thread_main, io);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (err != 0) {
+        fprintf(stderr, "pthread_create: %s\n", strerror(err));
+        close_transport(io);
+        return -1;
+    }
+    return 0;
+}
+
+void io_thread_stop(io_thread_t *io) {
+    atomic_store(&io->stop, 1);
+    if (io->shm_region) {
+        shm_server_notify(io->shm_region);
+    } else {
+        uint64_t one = 1;
+        if (write(io->wake_fd, &one, sizeof(one)) < 0) perror("write: wake up I/O thread");
+    }
+    pthread_join(io->thread, NULL);
+    if (io->shed > 0) {
+        fprintf(stderr, "%u applications were refused for lack of file descriptors\n", io->shed);
+    }
+    close_transport(io);
+}
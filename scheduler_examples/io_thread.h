@@ -0,0 +1,182 @@
+#ifndef IO_THREAD_H
+#define IO_THREAD_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "histogram.h"
+#include "msg.h"
+#include "queue.h"
+#include "transport.h"
+
+/*
+ * The I/O thread of the simulator owns the listening socket (or the shared memory segment) and
+ * every client connection: it accepts applications, reads and parses their requests and writes
+ * the ACK and DONE messages. The scheduling thread never makes a system call on behalf of a
+ * client, so a slow, flooding or vanished application cannot stretch a tick.
+ *
+ * The two threads only talk through two lock-free queues:
+ *  - events (I/O thread -> scheduler): a bounded multi-producer single-consumer queue of new
+ *    connections, requests and disconnections, which the control thread also uses for its
+ *    commands (see control.h);
+ *  - commands (scheduler -> I/O thread): a bounded single-producer single-consumer ring of
+ *    messages to send, connections to read again and connections to close.
+ *
+ * Both sides sleep only after announcing it, and are woken up by the other side only then, so a
+ * busy simulator exchanges messages with no system call besides those on the connections.
+ *
+ * A task's pcb_t is created by the I/O thread when its application connects and belongs to the
+ * scheduling thread from then on; the I/O thread only reads pcb->sockfd, which never changes.
+ * The I/O thread frees the pcb when the scheduler closes the connection.
+ */
+
+#define IO_QUEUE_SIZE 16384                 // Events and commands in flight, a power of two
+#define DEFAULT_BACKLOG 4096                // Pending connections of the listening socket, capped by net.core.somaxconn
+
+typedef enum {
+    IO_EVENT_CONNECTED = 0,                 // New application, pcb is in TASK_COMMAND
+    IO_EVENT_MESSAGE,                       // Request of an application
+    IO_EVENT_CLOSED,                        // Application went away or broke the protocol
+    IO_EVENT_CONTROL,                       // Command of the control socket, see control.h
+} io_event_en;
+
+struct control_request_st;
+
+typedef struct {
+    io_event_en type;
+    pcb_t *pcb;
+    msg_t msg;                              // IO_EVENT_MESSAGE
+    burst_msg_t *workload;                  // Bursts of a SUBMIT, to be freed by the receiver
+    struct control_request_st *control;     // IO_EVENT_CONTROL, to be answered with control_answer()
+    uint64_t received_ns;                   // monotonic_ns() when the I/O thread read the request
+} io_event_t;
+
+typedef enum {
+    IO_COMMAND_SEND = 0,                    // Send msg to the application
+    IO_COMMAND_WATCH,                       // Read the next request of the application
+    IO_COMMAND_CLOSE,                       // Close the connection and free the pcb
+} io_command_en;
+
+// Latency histograms of the messages sent by the I/O thread, see io_send()
+typedef enum {
+    IO_LATENCY_RUN_ACK = 0,
+    IO_LATENCY_BLOCK_ACK,
+    IO_LATENCY_SUBMIT_ACK,
+    IO_LATENCY_RUN_DONE,
+    IO_LATENCY_BLOCK_DONE,
+    IO_LATENCY_SUBMIT_DONE,
+    IO_LATENCY_COUNT,
+} io_latency_en;
+
+typedef struct {
+    io_command_en type;
+    pcb_t *pcb;
+    msg_t msg;                              // IO_COMMAND_SEND
+    io_latency_en latency;                  // IO_COMMAND_SEND: histogram of the message
+    uint64_t since_ns;                      // IO_COMMAND_SEND: start of the latency
+} io_command_t;
+
+typedef struct {
+    _Atomic uint64_t seq;                   // Position the cell is ready for, see io_thread.c
+    io_event_t event;
+} io_event_cell_t;
+
+typedef struct {
+    _Alignas(64) _Atomic uint64_t tail;     // Next position for a producer
+    _Alignas(64) uint64_t head;             // Next position for the consumer
+    io_event_cell_t cells[IO_QUEUE_SIZE];
+} io_event_queue_t;
+
+typedef struct {
+    _Alignas(64) _Atomic uint64_t head;     // Written by the scheduler
+    _Alignas(64) _Atomic uint64_t tail;     // Written by the I/O thread
+    io_command_t commands[IO_QUEUE_SIZE];
+} io_command_queue_t;
+
+typedef struct {
+    io_event_queue_t events;
+    io_command_queue_t commands;
+    _Atomic uint32_t events_posted;         // Futex word of the sleeping scheduler
+    _Atomic uint32_t sched_waiting;         // Scheduler sleeps on events_posted
+    _Atomic uint32_t io_waiting;            // I/O thread sleeps in epoll_wait or on the doorbell
+    _Atomic uint32_t stop;
+
+    // Owned by the I/O thread
+    transport_en transport;
+    int server_fd;
+    int epoll_fd;
+    int wake_fd;                            // eventfd written by the scheduler to wake up epoll_wait
+    int reserve_fd;                         // Given up to refuse connections when out of descriptors
+    uint32_t shed;                          // Connections refused that way
+    int shedding;                           // No connection accepted since the last refusal
+    shm_region_t *shm_region;
+    pcb_t *shm_clients[SHM_MAX_CLIENTS];
+    uint64_t shm_pending[SHM_MAX_CLIENTS / 64];     // Slots to look at
+    uint64_t shm_watched[SHM_MAX_CLIENTS / 64];     // Slots whose next request may be read
+    int32_t next_pid;
+    histogram_t latency[IO_LATENCY_COUNT];  // Read by the scheduler once the thread is stopped
+    pthread_t thread;
+} io_thread_t;
+
+/**
+ * @brief Sets up the transport and starts the I/O thread.
+ *
+ * The thread blocks every signal, so they keep interrupting the scheduling thread only.
+ * @param backlog Listen backlog of the socket, unused with shared memory.
+ * @return 0 on success, -1 on error.
+ */
+int io_thread_start(io_thread_t *io, transport_en transport, int backlog);
+
+/**
+ * @brief Stops the I/O thread and closes the transport. Connections still open are dropped.
+ */
+void io_thread_stop(io_thread_t *io);
+
+/**
+ * @brief Takes the next event of the I/O thread without blocking.
+ * @return 1 if an event was taken, 0 if there is none.
+ */
+int io_poll_event(io_thread_t *io, io_event_t *event);
+
+/**
+ * @brief Waits until an event is pending, without taking it.
+ * @param timeout_ms Maximum time to sleep, 0 to only check, -1 for no limit.
+ * @return Positive if an event is pending or a signal arrived, 0 on timeout.
+ */
+int io_wait_event(io_thread_t *io, int timeout_ms);
+
+/**
+ * @brief Hands a command of the control socket to the scheduler, from any thread but the I/O thread.
+ * @return 0 on success, -1 if the I/O thread is stopping.
+ */
+int io_post_control(io_thread_t *io, struct control_request_st *request);
+
+/**
+ * @brief Sends a message to the application of a task.
+ *
+ * The time from since_ns (monotonic_ns()) to the moment the message is written is recorded in
+ * the latency histogram of the message.
+ */
+void io_send(io_thread_t *io, pcb_t *pcb, process_request_t request, uint32_t time_ms,
+             io_latency_en latency, uint64_t since_ns);
+
+/**
+ * @brief Prints the latency histograms of the messages sent. The I/O thread must be stopped.
+ */
+void print_io_latency(const io_thread_t *io, FILE *out);
+
+/**
+ * @brief Lets the I/O thread read the next request of a task.
+ *
+ * After each IO_EVENT_MESSAGE the connection stays silent until this is called, so the requests
+ * of a task never pile up while it is busy.
+ */
+void io_watch(io_thread_t *io, pcb_t *pcb);
+
+/**
+ * @brief Closes the connection of a task. The pcb is freed by the I/O thread and must not be used afterwards.
+ */
+void io_close(io_thread_t *io, pcb_t *pcb);
+
+#endif //IO_THREAD_H
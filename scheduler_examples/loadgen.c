@@ -0,0 +1,384 @@
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "metrics.h"
+#include "msg.h"
+#include "scenario.h"
+#include "transport.h"
+
+#define EPOLL_BATCH 256             // Ready connections handled per epoll_wait call
+#define CONNECT_RETRY_MS 1          // Wait before retrying connections refused with EAGAIN (full backlog)
+
+/*
+ * Load generator: runs every application of a scenario file in this single process, each over
+ * its own non-blocking connection to SOCKET_PATH, with the RUN/BLOCK protocol of app-io. One
+ * epoll loop drives thousands of connections, so ossim can be stressed end to end without
+ * a process per application.
+ */
+
+typedef enum {
+    LOAD_WAITING = 0,               // Not connected yet
+    LOAD_ACK,                       // Request sent, waiting for its ACK
+    LOAD_DONE,                      // ACK received, waiting for the DONE
+    LOAD_FINISHED,                  // All bursts done, connection closed
+    LOAD_FAILED,                    // Protocol or connection error, connection closed
+} load_state_en;
+
+// State of one application, the non-blocking equivalent of app-io
+typedef struct {
+    int fd;
+    const batch_workload_t *workload;
+    uint32_t arrival_ms;            // Wall-clock offset of the connection from the start
+    load_state_en state;
+    uint32_t next_burst;            // Burst the current request refers to
+    int blocking;                   // Current request is the BLOCK of next_burst instead of its RUN
+    uint32_t requested_ms;          // Time field of the current request
+    uint64_t sent_ns;               // When the current request was written
+    uint32_t ack_ms;                // Simulation time of the ACK of the current request
+    int started;
+    uint32_t start_time_ms;         // Time of the first ACK
+    uint32_t sim_clock_ms;          // Time of the last ACK/DONE
+    uint32_t app_duration_ms;       // Sum of the bursts and blocks requested so far
+    uint8_t buf[sizeof(msg_t)];     // Partial message from the simulator
+    uint32_t buf_len;
+} load_app_t;
+
+// Growable array of samples
+typedef struct {
+    uint32_t *values;
+    uint32_t count;
+    uint32_t capacity;
+} samples_t;
+
+typedef struct {
+    load_app_t *apps;
+    uint32_t num_apps;
+    int epoll_fd;
+    int verbose;
+    uint32_t finished;
+    uint32_t failed;
+    uint32_t makespan_ms;           // Latest DONE seen
+    uint64_t start_ns;
+    uint32_t connected;             // Connections open now
+    uint32_t max_connected;
+    uint32_t connect_retries;       // connect() refused with EAGAIN because the backlog was full
+    samples_t connect_us;           // Wall time from the arrival time to the accepted connection
+    samples_t ack_us;               // Wall time from writing a request to reading its ACK
+    samples_t run_delay_ms;         // DONE of a RUN later than ACK + burst, in simulation time
+    samples_t block_delay_ms;       // DONE of a BLOCK later than ACK + block
+    samples_t elapsed_ms;           // First ACK to last DONE of each application
+} loadgen_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void add_sample(samples_t *s, uint32_t value) {
+    if (s->count == s->capacity) {
+        uint32_t capacity = s->capacity ? s->capacity * 2 : 1024;
+        uint32_t *tmp = realloc(s->values, capacity * sizeof(uint32_t));
+        if (!tmp) return;               // Drop the sample, the run goes on
+        s->values = tmp;
+        s->capacity = capacity;
+    }
+    s->values[s->count++] = value;
+}
+
+static void close_app(loadgen_t *lg, load_app_t *app, load_state_en state) {
+    close(app->fd);                 // Also drops the epoll registration
+    app->fd = -1;
+    lg->connected--;
+    app->state = state;
+    if (state == LOAD_FINISHED) {
+        lg->finished++;
+    } else {
+        lg->failed++;
+    }
+}
+
+/**
+ * @brief Writes the next RUN or BLOCK request of an application.
+ */
+static void send_request(loadgen_t *lg, load_app_t *app) {
+    const burst_msg_t *burst = &app->workload->bursts[app->next_burst];
+    msg_t msg = {
+        .pid = (pid_t)(app - lg->apps + 1),
+        .request = app->blocking ? PROCESS_REQUEST_BLOCK : PROCESS_REQUEST_RUN,
+        .time_ms = app->blocking ? burst->block_time_ms : burst->burst_time_ms
+    };
+    app->requested_ms = msg.time_ms;
+    app->sent_ns = now_ns();
+    // The simulator reads every request before answering, so the socket buffer is empty here
+    if (write(app->fd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
+        perror("write");
+        close_app(lg, app, LOAD_FAILED);
+        return;
+    }
+    app->state = LOAD_ACK;
+}
+
+/**
+ * @brief Connects an application whose arrival time has come.
+ * @return 0 if it is connected or failed for good, -1 if the simulator's backlog is full.
+ */
+static int connect_app(loadgen_t *lg, load_app_t *app) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        app->fd = -1;
+        lg->failed++;
+        app->state = LOAD_FAILED;
+        return 0;
+    }
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, SOCKET_PATH, sizeof(addr.sun_path) - 1);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        int err = errno;
+        close(fd);
+        if (err == EAGAIN) {
+            lg->connect_retries++;
+            return -1;
+        }
+        errno = err;
+        perror("connect");
+        app->fd = -1;
+        lg->failed++;
+        app->state = LOAD_FAILED;
+        return 0;
+    }
+    app->fd = fd;
+    if (++lg->connected > lg->max_connected) lg->max_connected = lg->connected;
+    add_sample(&lg->connect_us, (uint32_t)((now_ns() - lg->start_ns) / 1000 - (uint64_t)app->arrival_ms * 1000));
+    struct epoll_event ev = { .events = EPOLLIN, .data.u32 = (uint32_t)(app - lg->apps) };
+    if (epoll_ctl(lg->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        perror("epoll_ctl: add connection");
+        close_app(lg, app, LOAD_FAILED);
+        return 0;
+    }
+    app->blocking = 0;
+    send_request(lg, app);
+    return 0;
+}
+
+/**
+ * @brief Handles an ACK or a DONE and sends the next request, as handle_process_requests() of app-io.
+ */
+static void handle_message(loadgen_t *lg, load_app_t *app, const msg_t *msg) {
+    process_request_t expected = app->state == LOAD_ACK ? PROCESS_REQUEST_ACK : PROCESS_REQUEST_DONE;
+    if (msg->request != expected) {
+        fprintf(stderr, "Application %u: expected %s, received %s\n", (uint32_t)(app - lg->apps + 1),
+                PROCESS_REQUEST_STRINGS[expected], PROCESS_REQUEST_STRINGS[msg->request]);
+        close_app(lg, app, LOAD_FAILED);
+        return;
+    }
+    app->sim_clock_ms = msg->time_ms;
+    if (msg->time_ms > lg->makespan_ms) lg->makespan_ms = msg->time_ms;
+
+    if (app->state == LOAD_ACK) {
+        add_sample(&lg->ack_us, (uint32_t)((now_ns() - app->sent_ns) / 1000));
+        app->ack_ms = msg->time_ms;
+        if (!app->started) {
+            app->started = 1;
+            app->start_time_ms = msg->time_ms;
+        }
+        app->app_duration_ms += app->requested_ms;
+        app->state = LOAD_DONE;
+        return;
+    }
+
+    // A BLOCK may end a tick early (the tick of the request counts), such DONEs count as on time
+    uint32_t expected_ms = app->ack_ms + app->requested_ms;
+    uint32_t delay_ms = msg->time_ms > expected_ms ? msg->time_ms - expected_ms : 0;
+    add_sample(app->blocking ? &lg->block_delay_ms : &lg->run_delay_ms, delay_ms);
+
+    const burst_msg_t *burst = &app->workload->bursts[app->next_burst];
+    if (!app->blocking && burst->block_time_ms > 0) {
+        app->blocking = 1;
+    } else {
+        app->blocking = 0;
+        app->next_burst++;
+    }
+    if (app->next_burst < app->workload->count) {
+        send_request(lg, app);
+        return;
+    }
+
+    add_sample(&lg->elapsed_ms, app->sim_clock_ms - app->start_time_ms);
+    if (lg->verbose) {
+        printf("Application %s (PID %u) finished at time %u ms, Elapsed: %.03f seconds, CPU: %.03f seconds\n",
+               app->workload->name, (uint32_t)(app - lg->apps + 1), app->sim_clock_ms,
+               (app->sim_clock_ms - app->start_time_ms) / 1000.0, app->app_duration_ms / 1000.0);
+    }
+    close_app(lg, app, LOAD_FINISHED);
+}
+
+static void read_app(loadgen_t *lg, load_app_t *app) {
+    for (;;) {
+        ssize_t n = read(app->fd, app->buf + app->buf_len, sizeof(msg_t) - app->buf_len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+            perror("read");
+            close_app(lg, app, LOAD_FAILED);
+            return;
+        }
+        if (n == 0) {
+            fprintf(stderr, "Application %u: connection closed by the simulator\n", (uint32_t)(app - lg->apps + 1));
+            close_app(lg, app, LOAD_FAILED);
+            return;
+        }
+        app->buf_len += (uint32_t)n;
+        if (app->buf_len < sizeof(msg_t)) continue;
+        msg_t msg;
+        memcpy(&msg, app->buf, sizeof(msg_t));
+        app->buf_len = 0;
+        handle_message(lg, app, &msg);
+        if (app->fd < 0) return;
+    }
+}
+
+// Application waiting for its arrival time
+typedef struct {
+    uint32_t arrival_ms;
+    uint32_t index;
+} arrival_t;
+
+static int compare_arrival(const void *a, const void *b) {
+    const arrival_t *x = a, *y = b;
+    if (x->arrival_ms != y->arrival_ms) return (x->arrival_ms > y->arrival_ms) - (x->arrival_ms < y->arrival_ms);
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+static void print_report(loadgen_t *lg, double wall_s) {
+    metric_summary_t s;
+    printf("Load generator: %u applications finished, %u failed, last DONE at time %u ms, %.03f seconds of wall time\n",
+           lg->finished, lg->failed, lg->makespan_ms, wall_s);
+    printf("  %u connections open at most, %u connection attempts retried on a full backlog\n",
+           lg->max_connected, lg->connect_retries);
+    printf("  %-18s %8s %10s %8s %8s %8s %8s\n", "(us, wall time)", "count", "mean", "p50", "p95", "p99", "max");
+    summarize_values(lg->connect_us.values, lg->connect_us.count, &s);
+    print_summary_line(stdout, "arrival to connect", &s);
+    summarize_values(lg->ack_us.values, lg->ack_us.count, &s);
+    print_summary_line(stdout, "request to ACK", &s);
+    printf("  %-18s %8s %10s %8s %8s %8s %8s\n", "(ms, sim time)", "count", "mean", "p50", "p95", "p99", "max");
+    summarize_values(lg->run_delay_ms.values, lg->run_delay_ms.count, &s);
+    print_summary_line(stdout, "RUN DONE late", &s);
+    summarize_values(lg->block_delay_ms.values, lg->block_delay_ms.count, &s);
+    print_summary_line(stdout, "BLOCK DONE late", &s);
+    summarize_values(lg->elapsed_ms.values, lg->elapsed_ms.count, &s);
+    print_summary_line(stdout, "app elapsed", &s);
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options] <scenario>\n", prog);
+    printf("  -v, --verbose      print the app-io line of every application that finishes\n");
+    printf("The scenario has the format of ossim --batch, arrival times are wall-clock offsets from the start.\n");
+}
+
+int main(int argc, char *argv[]) {
+    int verbose = 0;
+
+    static const struct option long_options[] = {
+        {"verbose", no_argument, NULL, 'v'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "v", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'v':
+                verbose = 1;
+                break;
+            default:
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (optind != argc - 1) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    batch_scenario_t *scenario = load_scenario(argv[optind]);
+    if (!scenario) return EXIT_FAILURE;
+
+    loadgen_t lg = { .num_apps = scenario->num_apps, .verbose = verbose };
+    lg.apps = calloc(lg.num_apps, sizeof(load_app_t));
+    arrival_t *order = malloc(lg.num_apps * sizeof(arrival_t));
+    uint32_t *retry = malloc(lg.num_apps * sizeof(uint32_t));
+    lg.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (!lg.apps || !order || !retry || lg.epoll_fd < 0) {
+        perror(lg.epoll_fd < 0 ? "epoll_create1" : "malloc");
+        return EXIT_FAILURE;
+    }
+    for (uint32_t i = 0; i < lg.num_apps; i++) {
+        lg.apps[i].fd = -1;
+        lg.apps[i].workload = &scenario->workloads[scenario->apps[i].workload];
+        lg.apps[i].arrival_ms = scenario->apps[i].arrival_ms;
+        order[i] = (arrival_t){ .arrival_ms = scenario->apps[i].arrival_ms, .index = i };
+    }
+    qsort(order, lg.num_apps, sizeof(arrival_t), compare_arrival);
+    uint64_t fd_limit = raise_fd_limit();
+    if (fd_limit < (uint64_t)lg.num_apps + 16) {
+        fprintf(stderr, "Warning: %u applications but only %llu open files allowed (ulimit -n)\n",
+                lg.num_apps, (unsigned long long)fd_limit);
+    }
+
+    // Applications whose arrival time came, in arrival order: [retry_head, retry_tail) wait for a connection
+    uint32_t retry_head = 0, retry_tail = 0;
+    uint32_t next_arrival = 0;
+    struct epoll_event ready[EPOLL_BATCH];
+    lg.start_ns = now_ns();
+    while (lg.finished + lg.failed < lg.num_apps) {
+        uint64_t now_ms = (now_ns() - lg.start_ns) / 1000000;
+        while (next_arrival < lg.num_apps && order[next_arrival].arrival_ms <= now_ms) {
+            retry[retry_tail++] = order[next_arrival++].index;
+        }
+        while (retry_head < retry_tail && connect_app(&lg, &lg.apps[retry[retry_head]]) == 0) {
+            retry_head++;
+        }
+        if (lg.finished + lg.failed == lg.num_apps) break;       // The last ones failed to connect
+
+        int timeout_ms = -1;
+        if (retry_head < retry_tail) {
+            timeout_ms = CONNECT_RETRY_MS;
+        } else if (next_arrival < lg.num_apps) {
+            timeout_ms = (int)(order[next_arrival].arrival_ms - now_ms);
+        }
+        int nready = epoll_wait(lg.epoll_fd, ready, EPOLL_BATCH, timeout_ms);
+        if (nready < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < nready; i++) {
+            load_app_t *app = &lg.apps[ready[i].data.u32];
+            if (app->fd >= 0) read_app(&lg, app);
+        }
+    }
+    double wall_s = (double)(now_ns() - lg.start_ns) / 1e9;
+
+    print_report(&lg, wall_s);
+
+    close(lg.epoll_fd);
+    free(lg.connect_us.values);
+    free(lg.ack_us.values);
+    free(lg.run_delay_ms.values);
+    free(lg.block_delay_ms.values);
+    free(lg.elapsed_ms.values);
+    free(retry);
+    free(order);
+    free(lg.apps);
+    free_scenario(scenario);
+    return lg.failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,169 @@
+#include "machine.h"
+
+#include <stdlib.h>
+
+#include "mlfq.h"
+#include "msg.h"
+
+int machine_init(machine_t *m, const scheduler_policy_t *policy, const policy_config_t *config, uint32_t num_cpus) {
+    m->policy = policy;
+    m->num_cpus = 0;
+    m->cpus = calloc(num_cpus, sizeof(cpu_t));
+    if (!m->cpus) return -1;
+    for (; m->num_cpus < num_cpus; m->num_cpus++) {
+        m->cpus[m->num_cpus].rq = policy->init(config);
+        if (!m->cpus[m->num_cpus].rq) {
+            machine_destroy(m);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void machine_destroy(machine_t *m) {
+    for (uint32_t c = 0; c < m->num_cpus; c++) {
+        m->policy->destroy(m->cpus[c].rq);
+    }
+    free(m->cpus);
+    m->cpus = NULL;
+    m->num_cpus = 0;
+}
+
+int machine_enqueue(machine_t *m, pcb_t *task) {
+    if (task->cpu >= m->num_cpus) {
+        uint32_t best_load = UINT32_MAX;
+        for (uint32_t c = 0; c < m->num_cpus; c++) {
+            uint32_t load = m->policy->ready_count(m->cpus[c].rq) + (m->cpus[c].task != NULL);
+            if (load < best_load) {
+                best_load = load;
+                task->cpu = c;
+            }
+        }
+    }
+    return m->policy->enqueue(m->cpus[task->cpu].rq, task);
+}
+
+/**
+ * @brief Takes the task the busiest other CPU would run next.
+ */
+static pcb_t *steal(machine_t *m, uint32_t thief, uint32_t current_time_ms) {
+    uint32_t victim = NO_CPU;
+    uint32_t most = 0;
+    for (uint32_t c = 0; c < m->num_cpus; c++) {
+        uint32_t count = c == thief ? 0 : m->policy->ready_count(m->cpus[c].rq);
+        if (count > most) {
+            most = count;
+            victim = c;
+        }
+    }
+    if (victim == NO_CPU) return NULL;
+    return m->policy->pick(m->cpus[victim].rq, current_time_ms);
+}
+
+void machine_tick(machine_t *m, uint32_t current_time_ms) {
+    uint32_t idle = 0;
+    for (uint32_t c = 0; c < m->num_cpus; c++) {
+        cpu_t *cpu = &m->cpus[c];
+        cpu->prev = cpu->task;
+        m->policy->tick(cpu->rq, current_time_ms, &cpu->task);
+        cpu->preempted = cpu->prev && cpu->prev->preempted;
+        if (cpu->preempted) cpu->prev->preempted = 0;
+        if (cpu->task == NULL) {
+            cpu->task = m->policy->pick(cpu->rq, current_time_ms);
+        }
+        if (cpu->task == NULL) idle++;
+    }
+    // Steal only once every CPU had the chance to run its own tasks
+    for (uint32_t c = 0; idle > 0 && c < m->num_cpus; c++) {
+        if (m->cpus[c].task) continue;
+        m->cpus[c].task = steal(m, c, current_time_ms);
+        if (!m->cpus[c].task) break;        // Nothing left to steal anywhere
+        idle--;
+    }
+
+    for (uint32_t c = 0; c < m->num_cpus; c++) {
+        cpu_t *cpu = &m->cpus[c];
+        if (cpu->task == cpu->prev && !cpu->preempted) continue;
+        if (cpu->prev) {
+            cpu->busy_ms += current_time_ms - cpu->dispatch_ms;
+        }
+        if (cpu->task) {
+            if (cpu->task->cpu != c) {
+                cpu->migrations++;
+                cpu->task->cpu = c;
+            }
+            cpu->dispatch_ms = current_time_ms;
+            cpu->dispatches++;
+        }
+    }
+}
+
+uint32_t machine_ready_count(const machine_t *m) {
+    uint32_t count = 0;
+    for (uint32_t c = 0; c < m->num_cpus; c++) {
+        count += m->policy->ready_count(m->cpus[c].rq);
+    }
+    return count;
+}
+
+uint32_t machine_level_counts(const machine_t *m, uint32_t *ready) {
+    if (!m->policy->level_counts) {
+        ready[0] = machine_ready_count(m);
+        return 1;
+    }
+    uint32_t counts[MAX_MLFQ_LEVELS];
+    uint32_t levels = 0;
+    for (uint32_t c = 0; c < m->num_cpus; c++) {
+        levels = m->policy->level_counts(m->cpus[c].rq, counts);
+        for (uint32_t l = 0; l < levels; l++) {
+            ready[l] = (c > 0 ? ready[l] : 0) + counts[l];
+        }
+    }
+    return levels;
+}
+
+int machine_set_quantum(machine_t *m, uint32_t level, uint32_t quantum_ms) {
+    if (!m->policy->set_quantum) return -1;
+    for (uint32_t c = 0; c < m->num_cpus; c++) {
+        if (m->policy->set_quantum(m->cpus[c].rq, level, quantum_ms) < 0) return -1;
+    }
+    return 0;
+}
+
+uint32_t machine_next_event_ms(const machine_t *m, uint32_t current_time_ms) {
+    uint32_t next_ms = UINT32_MAX;
+    int idle = 0;
+    for (uint32_t c = 0; c < m->num_cpus; c++) {
+        const cpu_t *cpu = &m->cpus[c];
+        if (!cpu->task) {
+            idle = 1;
+            continue;
+        }
+        event_type_en type;
+        uint32_t event_ms = next_cpu_event_ms(m->policy, cpu->rq, cpu->task, current_time_ms, &type);
+        if (event_ms < next_ms) next_ms = event_ms;
+    }
+    if (idle && machine_ready_count(m) > 0) {
+        next_ms = current_time_ms + TICKS_MS;   // Dispatch pending
+    }
+    return next_ms;
+}
+
+void machine_skip(machine_t *m, uint32_t skipped_ms) {
+    for (uint32_t c = 0; c < m->num_cpus; c++) {
+        if (m->cpus[c].task) m->cpus[c].task->ellapsed_time_ms += skipped_ms;
+    }
+}
+
+void print_cpu_stats(const machine_t *m, const metrics_t *metrics, FILE *out) {
+    if (m->num_cpus < 2) return;
+
+    uint64_t span_ms = metrics->started ? metrics->last_completion_ms - metrics->first_arrival_ms : 0;
+    fprintf(out, "  %-6s %12s %8s %10s %10s\n", "CPU", "busy (ms)", "util", "dispatches", "migrations");
+    for (uint32_t c = 0; c < m->num_cpus; c++) {
+        const cpu_t *cpu = &m->cpus[c];
+        double util = span_ms ? (double)cpu->busy_ms / (double)span_ms * 100.0 : 0.0;
+        fprintf(out, "  %-6u %12llu %7.1f%% %10u %10u\n", c, (unsigned long long)cpu->busy_ms, util,
+                cpu->dispatches, cpu->migrations);
+    }
+}
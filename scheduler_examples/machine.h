@@ -0,0 +1,98 @@
+#ifndef MACHINE_H
+#define MACHINE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "metrics.h"
+#include "policy.h"
+#include "queue.h"
+
+#define MAX_CPUS 1024
+#define NO_CPU UINT32_MAX           // pcb->cpu of a task that was never queued
+
+// One simulated CPU, with its own ready queue
+typedef struct {
+    void *rq;                       // Ready queue of the CPU, state of the policy
+    pcb_t *task;                    // Running task, NULL when idle
+    pcb_t *prev;                    // Task that was running before the last machine_tick()
+    int preempted;                  // prev was preempted at the last machine_tick(), even if it got the CPU back
+    uint32_t dispatch_ms;           // When task got the CPU
+    uint64_t busy_ms;               // Time spent running tasks
+    uint32_t dispatches;            // Tasks put on the CPU
+    uint32_t migrations;            // Tasks stolen from the ready queue of another CPU
+} cpu_t;
+
+/*
+ * A machine with num_cpus CPUs running the same policy. Every CPU has its own instance of the
+ * policy's ready queue, and a task stays on the queue of the CPU it last ran on. A CPU that goes
+ * idle with an empty queue steals the task the busiest queue would run next. With one CPU this
+ * is exactly the uniprocessor simulator.
+ */
+typedef struct {
+    const scheduler_policy_t *policy;
+    cpu_t *cpus;
+    uint32_t num_cpus;
+} machine_t;
+
+/**
+ * @brief Creates the CPUs and one ready queue per CPU.
+ * @return 0 on success, -1 on error.
+ */
+int machine_init(machine_t *m, const scheduler_policy_t *policy, const policy_config_t *config, uint32_t num_cpus);
+
+void machine_destroy(machine_t *m);
+
+/**
+ * @brief Puts a task that requested RUN in a ready queue.
+ *
+ * The task goes back to the CPU it last ran on; a new task goes to the least loaded CPU.
+ */
+int machine_enqueue(machine_t *m, pcb_t *task);
+
+/**
+ * @brief Runs one tick on every CPU.
+ *
+ * Each CPU first accounts the tick to its task and picks from its own queue if it is idle,
+ * then the CPUs still idle steal from the others. cpus[c].prev and cpus[c].task tell the caller
+ * how each CPU changed, as prev_CPU and CPU do on a single CPU, and cpus[c].preempted whether prev
+ * was preempted: a task whose quantum expired may be picked again right away.
+ */
+void machine_tick(machine_t *m, uint32_t current_time_ms);
+
+/**
+ * @brief Number of tasks in all the ready queues.
+ */
+uint32_t machine_ready_count(const machine_t *m);
+
+/**
+ * @brief Number of tasks at each priority level, over all the ready queues.
+ * @param ready Room for MAX_MLFQ_LEVELS counts.
+ * @return Number of levels of the policy, 1 if it has a single ready queue.
+ */
+uint32_t machine_level_counts(const machine_t *m, uint32_t *ready);
+
+/**
+ * @brief Changes the quantum of a level on every CPU. Running tasks see it from the next tick.
+ * @return 0 on success, -1 if the policy has no quantum or no such level.
+ */
+int machine_set_quantum(machine_t *m, uint32_t level, uint32_t quantum_ms);
+
+/**
+ * @brief Time of the next burst completion, quantum expiry or dispatch on any CPU, see next_cpu_event_ms().
+ * @return UINT32_MAX if all CPUs are idle and nothing is ready.
+ */
+uint32_t machine_next_event_ms(const machine_t *m, uint32_t current_time_ms);
+
+/**
+ * @brief Accounts skipped_ms of running time to the task of every busy CPU.
+ */
+void machine_skip(machine_t *m, uint32_t skipped_ms);
+
+/**
+ * @brief Prints the utilization, dispatches and migrations of each CPU.
+ *
+ * Utilization is relative to the span of the recorded metrics. Nothing is printed on one CPU.
+ */
+void print_cpu_stats(const machine_t *m, const metrics_t *metrics, FILE *out);
+
+#endif //MACHINE_H
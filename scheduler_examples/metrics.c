@@ -0,0 +1,227 @@
+#include "metrics.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define METRICS_INITIAL_CAPACITY 256
+
+static void add_open_task(metrics_t *m, pcb_t *task) {
+    if (m->num_open == m->open_capacity) {
+        uint32_t new_capacity = m->open_capacity ? m->open_capacity * 2 : METRICS_INITIAL_CAPACITY;
+        pcb_t **tmp = realloc(m->open, new_capacity * sizeof(pcb_t *));
+        if (!tmp) {
+            perror("realloc");
+            return;
+        }
+        m->open = tmp;
+        m->open_capacity = new_capacity;
+    }
+    task->stats.open_index = m->num_open;
+    m->open[m->num_open++] = task;
+}
+
+static void remove_open_task(metrics_t *m, const pcb_t *task) {
+    uint32_t i = task->stats.open_index;
+    if (i >= m->num_open || m->open[i] != task) return;     // Not added, out of memory
+    m->open[i] = m->open[--m->num_open];
+    m->open[i]->stats.open_index = i;
+}
+
+void metrics_burst_arrival(metrics_t *m, pcb_t *task, uint32_t current_time_ms) {
+    pcb_stats_t *s = &task->stats;
+    if (s->bursts == 0) {
+        s->arrival_ms = current_time_ms;
+        add_open_task(m, task);
+    }
+    s->bursts++;
+    s->burst_arrival_ms = current_time_ms;
+    s->burst_first_run_ms = UINT32_MAX;
+    s->burst_wait_ms = 0;
+    s->burst_preemptions = 0;
+    s->ready_since_ms = current_time_ms;
+
+    if (!m->started) {
+        m->started = 1;
+        m->first_arrival_ms = current_time_ms;
+    }
+}
+
+static void record_burst(metrics_t *m, const pcb_t *task, uint32_t current_time_ms) {
+    if (m->num_bursts == m->bursts_capacity) {
+        uint32_t new_capacity = m->bursts_capacity ? m->bursts_capacity * 2 : METRICS_INITIAL_CAPACITY;
+        burst_record_t *tmp = realloc(m->bursts, new_capacity * sizeof(burst_record_t));
+        if (!tmp) {
+            perror("realloc");
+            return;
+        }
+        m->bursts = tmp;
+        m->bursts_capacity = new_capacity;
+    }
+    const pcb_stats_t *s = &task->stats;
+    m->bursts[m->num_bursts++] = (burst_record_t){
+        .pid = task->pid,
+        .arrival_ms = s->burst_arrival_ms,
+        .first_run_ms = s->burst_first_run_ms,
+        .wait_ms = s->burst_wait_ms,
+        .preemptions = s->burst_preemptions,
+        .completion_ms = current_time_ms,
+    };
+}
+
+void metrics_cpu_switch(metrics_t *m, pcb_t *prev, pcb_t *cpu, int preempted, uint32_t current_time_ms) {
+    if (prev == cpu && !preempted) return;
+
+    if (prev) {
+        pcb_stats_t *s = &prev->stats;
+        m->busy_ms += current_time_ms - s->dispatch_ms;
+        if (prev->status == TASK_STOPPED) {
+            s->last_done_ms = current_time_ms;
+            if (current_time_ms > m->last_completion_ms) m->last_completion_ms = current_time_ms;
+            record_burst(m, prev, current_time_ms);
+        } else {
+            s->burst_preemptions++;
+            s->preemptions++;
+            s->ready_since_ms = current_time_ms;
+            m->preemptions++;
+        }
+    }
+
+    if (cpu) {
+        pcb_stats_t *s = &cpu->stats;
+        uint32_t waited = current_time_ms - s->ready_since_ms;
+        s->burst_wait_ms += waited;
+        s->wait_ms += waited;
+        if (s->burst_first_run_ms == UINT32_MAX) {
+            s->burst_first_run_ms = current_time_ms;
+            if (s->bursts == 1) s->response_ms = current_time_ms - s->arrival_ms;
+        }
+        s->dispatch_ms = current_time_ms;
+        if (cpu != prev) m->context_switches++;
+    }
+}
+
+void metrics_task_exit(metrics_t *m, const pcb_t *task) {
+    const pcb_stats_t *s = &task->stats;
+    if (s->bursts == 0) return;
+    remove_open_task(m, task);
+
+    if (m->num_tasks == m->tasks_capacity) {
+        uint32_t new_capacity = m->tasks_capacity ? m->tasks_capacity * 2 : METRICS_INITIAL_CAPACITY;
+        task_record_t *tmp = realloc(m->tasks, new_capacity * sizeof(task_record_t));
+        if (!tmp) {
+            perror("realloc");
+            return;
+        }
+        m->tasks = tmp;
+        m->tasks_capacity = new_capacity;
+    }
+    m->tasks[m->num_tasks++] = (task_record_t){
+        .pid = task->pid,
+        .arrival_ms = s->arrival_ms,
+        .response_ms = s->response_ms,
+        .wait_ms = s->wait_ms,
+        .preemptions = s->preemptions,
+        .bursts = s->bursts,
+        .completion_ms = s->last_done_ms,
+    };
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted values
+static uint32_t percentile(const uint32_t *sorted, uint32_t count, uint32_t p) {
+    uint32_t rank = (uint32_t)(((uint64_t)p * count + 99) / 100);
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+void summarize_values(uint32_t *values, uint32_t count, metric_summary_t *summary) {
+    memset(summary, 0, sizeof(*summary));
+    summary->count = count;
+    if (count == 0) return;
+
+    qsort(values, count, sizeof(uint32_t), compare_u32);
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < count; i++) sum += values[i];
+    summary->mean = (double)sum / count;
+    summary->p50 = percentile(values, count, 50);
+    summary->p95 = percentile(values, count, 95);
+    summary->p99 = percentile(values, count, 99);
+    summary->max = values[count - 1];
+}
+
+int summarize_metrics(const metrics_t *m, metrics_summary_t *summary) {
+    memset(summary, 0, sizeof(*summary));
+    uint32_t num_tasks = m->num_tasks + m->num_open;
+    uint32_t n = m->num_bursts > num_tasks ? m->num_bursts : num_tasks;
+    uint32_t *values = malloc((n ? n : 1) * sizeof(uint32_t));
+    if (!values) return -1;
+
+    // Open tasks have no turnaround yet, and no response before their first dispatch
+    for (uint32_t i = 0; i < m->num_tasks; i++) values[i] = m->tasks[i].completion_ms - m->tasks[i].arrival_ms;
+    summarize_values(values, m->num_tasks, &summary->task_turnaround);
+    for (uint32_t i = 0; i < m->num_tasks; i++) values[i] = m->tasks[i].wait_ms;
+    for (uint32_t i = 0; i < m->num_open; i++) values[m->num_tasks + i] = m->open[i]->stats.wait_ms;
+    summarize_values(values, num_tasks, &summary->task_wait);
+    n = 0;
+    for (uint32_t i = 0; i < m->num_tasks; i++) values[n++] = m->tasks[i].response_ms;
+    for (uint32_t i = 0; i < m->num_open; i++) {
+        const pcb_stats_t *s = &m->open[i]->stats;
+        if (s->bursts > 1 || s->burst_first_run_ms != UINT32_MAX) values[n++] = s->response_ms;
+    }
+    summarize_values(values, n, &summary->task_response);
+
+    for (uint32_t i = 0; i < m->num_bursts; i++) values[i] = m->bursts[i].completion_ms - m->bursts[i].arrival_ms;
+    summarize_values(values, m->num_bursts, &summary->burst_turnaround);
+    for (uint32_t i = 0; i < m->num_bursts; i++) values[i] = m->bursts[i].wait_ms;
+    summarize_values(values, m->num_bursts, &summary->burst_wait);
+    for (uint32_t i = 0; i < m->num_bursts; i++) values[i] = m->bursts[i].first_run_ms - m->bursts[i].arrival_ms;
+    summarize_values(values, m->num_bursts, &summary->burst_response);
+    free(values);
+
+    // Up to the last completion, nothing while no burst has completed
+    uint64_t span_ms = m->started && m->last_completion_ms > m->first_arrival_ms
+                       ? m->last_completion_ms - m->first_arrival_ms : 0;
+    span_ms *= m->num_cpus > 1 ? m->num_cpus : 1;
+    summary->busy_ms = m->busy_ms;
+    summary->idle_ms = span_ms > m->busy_ms ? span_ms - m->busy_ms : 0;
+    if (summary->busy_ms + summary->idle_ms > 0) {
+        summary->cpu_utilization = (double)summary->busy_ms / (double)(summary->busy_ms + summary->idle_ms);
+    }
+    summary->context_switches = m->context_switches;
+    summary->preemptions = m->preemptions;
+    return 0;
+}
+
+void print_summary_line(FILE *out, const char *name, const metric_summary_t *s) {
+    fprintf(out, "  %-18s %8u %10.1f %8u %8u %8u %8u\n", name, s->count, s->mean, s->p50, s->p95, s->p99, s->max);
+}
+
+void print_metrics(const metrics_t *m, FILE *out) {
+    metrics_summary_t s;
+    if (summarize_metrics(m, &s) < 0) {
+        perror("summarize_metrics");
+        return;
+    }
+    fprintf(out, "Scheduler metrics: %u tasks (%u still connected), %u bursts, CPU busy %llu ms, idle %llu ms (%.1f%% utilization), "
+                 "%u context switches, %u preemptions\n",
+            m->num_tasks + m->num_open, m->num_open, m->num_bursts, (unsigned long long)s.busy_ms, (unsigned long long)s.idle_ms,
+            s.cpu_utilization * 100.0, s.context_switches, s.preemptions);
+    fprintf(out, "  %-18s %8s %10s %8s %8s %8s %8s\n", "(ms)", "count", "mean", "p50", "p95", "p99", "max");
+    print_summary_line(out, "task turnaround", &s.task_turnaround);
+    print_summary_line(out, "task wait", &s.task_wait);
+    print_summary_line(out, "task response", &s.task_response);
+    print_summary_line(out, "burst turnaround", &s.burst_turnaround);
+    print_summary_line(out, "burst wait", &s.burst_wait);
+    print_summary_line(out, "burst response", &s.burst_response);
+}
+
+void free_metrics(metrics_t *m) {
+    free(m->bursts);
+    free(m->tasks);
+    free(m->open);
+    memset(m, 0, sizeof(*m));
+}
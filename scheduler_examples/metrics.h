@@ -0,0 +1,122 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "queue.h"
+
+// One completed CPU burst
+typedef struct {
+    int32_t pid;
+    uint32_t arrival_ms;            // RUN request
+    uint32_t first_run_ms;          // First dispatch
+    uint32_t wait_ms;               // Time spent in the ready queue
+    uint32_t preemptions;
+    uint32_t completion_ms;
+} burst_record_t;
+
+// One task that left the simulator
+typedef struct {
+    int32_t pid;
+    uint32_t arrival_ms;            // First RUN request
+    uint32_t response_ms;           // Time from the first RUN request to the first dispatch
+    uint32_t wait_ms;               // Total time spent in the ready queue
+    uint32_t preemptions;
+    uint32_t bursts;
+    uint32_t completion_ms;         // Completion of the last CPU burst
+} task_record_t;
+
+// Records and CPU counters of a whole simulation, on the simulator's clock
+typedef struct {
+    burst_record_t *bursts;
+    uint32_t num_bursts;
+    uint32_t bursts_capacity;
+    task_record_t *tasks;
+    uint32_t num_tasks;
+    uint32_t tasks_capacity;
+    pcb_t **open;                   // Tasks that asked for the CPU and are still connected
+    uint32_t num_open;
+    uint32_t open_capacity;
+    uint64_t busy_ms;               // Time the CPUs spent running tasks
+    uint32_t num_cpus;              // CPUs of the simulated machine, 0 counts as 1
+    uint32_t context_switches;      // Dispatches of a task other than the one already on the CPU
+    uint32_t preemptions;           // Expired quanta, including those of a task that got the CPU back
+    int started;                    // Set by the first RUN request
+    uint32_t first_arrival_ms;
+    uint32_t last_completion_ms;
+} metrics_t;
+
+// Distribution of one metric, in milliseconds unless noted otherwise
+typedef struct {
+    uint32_t count;
+    double mean;
+    uint32_t p50;
+    uint32_t p95;
+    uint32_t p99;
+    uint32_t max;
+} metric_summary_t;
+
+typedef struct {
+    metric_summary_t task_turnaround;
+    metric_summary_t task_wait;
+    metric_summary_t task_response;
+    metric_summary_t burst_turnaround;
+    metric_summary_t burst_wait;
+    metric_summary_t burst_response;
+    uint64_t busy_ms;
+    uint64_t idle_ms;               // CPU time without a running task between the first arrival and the last completion
+    double cpu_utilization;         // busy / (busy + idle), 0 when nothing ran
+    uint32_t context_switches;
+    uint32_t preemptions;
+} metrics_summary_t;
+
+/**
+ * @brief Records the RUN request of a task, when its burst enters the ready queue.
+ */
+void metrics_burst_arrival(metrics_t *m, pcb_t *task, uint32_t current_time_ms);
+
+/**
+ * @brief Records the CPU moving from prev to cpu at the current tick.
+ *
+ * Called after every scheduling decision with the task that was on the CPU before the tick,
+ * the one on it now and whether prev was preempted (cpu_t.preempted). A task that left the CPU
+ * with status TASK_STOPPED finished its burst, a preempted one is back in the ready queue or,
+ * when prev == cpu, was dispatched again at once.
+ */
+void metrics_cpu_switch(metrics_t *m, pcb_t *prev, pcb_t *cpu, int preempted, uint32_t current_time_ms);
+
+/**
+ * @brief Records a task leaving the simulator. Tasks that never asked for the CPU are ignored.
+ *
+ * Until then the task is an open row of the summary: its wait and response so far count, its
+ * turnaround does not.
+ */
+void metrics_task_exit(metrics_t *m, const pcb_t *task);
+
+/**
+ * @brief Computes mean, p50, p95, p99 and maximum of the recorded tasks and bursts.
+ *
+ * Tasks still connected are included as open rows, see metrics_task_exit().
+ *
+ * @return 0 on success, -1 if memory for sorting could not be allocated.
+ */
+int summarize_metrics(const metrics_t *m, metrics_summary_t *summary);
+
+/**
+ * @brief Sorts the values in place and fills in their summary.
+ */
+void summarize_values(uint32_t *values, uint32_t count, metric_summary_t *summary);
+
+/**
+ * @brief Prints one row of the table of print_metrics().
+ */
+void print_summary_line(FILE *out, const char *name, const metric_summary_t *summary);
+
+/**
+ * @brief Prints the summary of the recorded metrics as a small table.
+ */
+void print_metrics(const metrics_t *m, FILE *out);
+
+void free_metrics(metrics_t *m);
+
+#endif //METRICS_H
@@ -1,55 +1,204 @@
 #include "mlfq.h"
 #include "msg.h"
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
-void mlfq_scheduler(uint32_t current_time_ms, mlfq_ready_t *rq, pcb_t **cpu_task) {
+#define MAX_LINE_LEN 1024
+
+int mlfq_init(mlfq_ready_t *rq, uint32_t num_levels, const uint32_t *quanta) {
+    if (num_levels == 0 || num_levels > MAX_MLFQ_LEVELS) return -1;
+
+    memset(rq, 0, sizeof(*rq));
+    rq->num_levels = num_levels;
+    for (uint32_t i = 0; i < num_levels; i++) {
+        rq->quanta[i] = quanta[i];
+    }
+    return 0;
+}
+
+static int parse_quantum(const char *token, uint32_t *quantum) {
+    char *endptr;
+    long value = strtol(token, &endptr, 10);
+    while (isspace((unsigned char)*endptr)) endptr++;
+    if (endptr == token || *endptr != '\0' || value <= 0 || value > UINT32_MAX) {
+        fprintf(stderr, "Invalid quantum: %s\n", token);
+        return -1;
+    }
+    *quantum = (uint32_t)value;
+    return 0;
+}
+
+int mlfq_parse_quanta(const char *list, uint32_t *quanta) {
+    char *copy = strdup(list);
+    if (!copy) return -1;
+
+    int count = 0;
+    for (char *token = strtok(copy, ","); token != NULL; token = strtok(NULL, ",")) {
+        if (count == MAX_MLFQ_LEVELS) {
+            fprintf(stderr, "Too many MLFQ levels, at most %d are supported\n", MAX_MLFQ_LEVELS);
+            count = -1;
+            break;
+        }
+        if (parse_quantum(token, &quanta[count]) < 0) {
+            count = -1;
+            break;
+        }
+        count++;
+    }
+    free(copy);
+    return count;
+}
+
+int mlfq_read_quanta_file(const char *filename, uint32_t *quanta) {
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        perror("fopen");
+        return -1;
+    }
+
+    char line[MAX_LINE_LEN];
+    int count = 0;
+    while (fgets(line, sizeof(line), file)) {
+        char *comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+        char *trimmed = line;
+        while (isspace((unsigned char)*trimmed)) ++trimmed;
+        if (*trimmed == '\0') continue;
+
+        if (count == MAX_MLFQ_LEVELS) {
+            fprintf(stderr, "Too many MLFQ levels, at most %d are supported\n", MAX_MLFQ_LEVELS);
+            count = -1;
+            break;
+        }
+        if (parse_quantum(trimmed, &quanta[count]) < 0) {
+            count = -1;
+            break;
+        }
+        count++;
+    }
+    fclose(file);
+    return count;
+}
+
+int mlfq_enqueue(mlfq_ready_t *rq, uint32_t level, pcb_t *task) {
+    if (!enqueue_pcb(&rq->levels[level], task)) return 0;
+    rq->non_empty |= UINT64_C(1) << level;
+    return 1;
+}
+
+static pcb_t *mlfq_dequeue(mlfq_ready_t *rq, uint32_t level) {
+    pcb_t *task = dequeue_pcb(&rq->levels[level]);
+    if (!rq->levels[level].head) {
+        rq->non_empty &= ~(UINT64_C(1) << level);
+    }
+    return task;
+}
+
+static void mlfq_tick(void *ready, uint32_t current_time_ms, pcb_t **cpu_task) {
+    mlfq_ready_t *rq = ready;
     if (*cpu_task) {
         // Accumulate elapsed time for the current burst
         (*cpu_task)->ellapsed_time_ms += TICKS_MS;
 
         if ((*cpu_task)->ellapsed_time_ms >= (*cpu_task)->time_ms) {
             // Task finished its CPU burst
-            msg_t msg = {
-                .pid = (*cpu_task)->pid,
-                .request = PROCESS_REQUEST_DONE,
-                .time_ms = current_time_ms
-            };
-
-            if (write((*cpu_task)->sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
-                perror("write");
-            }
-
-            // Do not free here; main loop will re-enqueue to command_queue
+            finish_burst(*cpu_task, current_time_ms);
             *cpu_task = NULL;
             return;
         }
 
         // Check if quantum exceeded for preemption
-        uint32_t slice_elapsed_ms = current_time_ms - (*cpu_task)->slice_start_ms + TICKS_MS;  // Approximate including current tick
         uint8_t level = (*cpu_task)->level;
-        if (slice_elapsed_ms >= rq->quanta[level]) {
+        if (quantum_expired(*cpu_task, rq->quanta[level], current_time_ms)) {
             // Preempt: demote to next level if possible
             (*cpu_task)->slice_start_ms = current_time_ms;  // Reset slice for potential re-run
-            if (level < NUM_MLFQ_LEVELS - 1) {
+            if (level < rq->num_levels - 1) {
                 (*cpu_task)->level = level + 1;
             }
             // Re-enqueue to the appropriate level
-            enqueue_pcb(&rq->levels[(*cpu_task)->level], *cpu_task);
+            preempt_burst(*cpu_task);
+            mlfq_enqueue(rq, (*cpu_task)->level, *cpu_task);
             *cpu_task = NULL;
-            return;
         }
     }
+}
 
+static pcb_t *mlfq_pick(void *ready, uint32_t current_time_ms) {
+    mlfq_ready_t *rq = ready;
     // CPU is idle: select next task from highest priority non-empty level
-    for (int l = 0; l < NUM_MLFQ_LEVELS; l++) {
-        if (rq->levels[l].head != NULL) {
-            *cpu_task = dequeue_pcb(&rq->levels[l]);
-            if (*cpu_task) {
-                (*cpu_task)->slice_start_ms = current_time_ms;
-                break;
-            }
-        }
+    if (!rq->non_empty) return NULL;
+
+    uint32_t l = (uint32_t)__builtin_ctzll(rq->non_empty);
+    pcb_t *task = mlfq_dequeue(rq, l);
+    task->slice_start_ms = current_time_ms;
+    return task;
+}
+
+void mlfq_scheduler(uint32_t current_time_ms, mlfq_ready_t *rq, pcb_t **cpu_task) {
+    mlfq_tick(rq, current_time_ms, cpu_task);
+
+    if (*cpu_task == NULL) {
+        *cpu_task = mlfq_pick(rq, current_time_ms);
     }
-}
\ No newline at end of file
+}
+
+static void *mlfq_policy_init(const policy_config_t *config) {
+    mlfq_ready_t *rq = malloc(sizeof(mlfq_ready_t));
+    if (!rq) return NULL;
+    if (mlfq_init(rq, config->mlfq_levels, config->mlfq_quanta) < 0) {
+        fprintf(stderr, "Invalid number of MLFQ levels: %u\n", config->mlfq_levels);
+        free(rq);
+        return NULL;
+    }
+    return rq;
+}
+
+static int mlfq_policy_enqueue(void *rq, pcb_t *task) {
+    // New tasks or post-I/O start at level 0
+    task->level = 0;
+    return mlfq_enqueue((mlfq_ready_t *)rq, 0, task);
+}
+
+static uint32_t mlfq_ready_count(const void *ready) {
+    const mlfq_ready_t *rq = ready;
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < rq->num_levels; i++) {
+        count += rq->levels[i].count;
+    }
+    return count;
+}
+
+static uint32_t mlfq_quantum_ms(const void *rq, const pcb_t *task) {
+    return ((const mlfq_ready_t *)rq)->quanta[task->level];
+}
+
+static uint32_t mlfq_level_counts(const void *ready, uint32_t *counts) {
+    const mlfq_ready_t *rq = ready;
+    for (uint32_t i = 0; i < rq->num_levels; i++) {
+        counts[i] = rq->levels[i].count;
+    }
+    return rq->num_levels;
+}
+
+static int mlfq_set_quantum(void *ready, uint32_t level, uint32_t quantum_ms) {
+    mlfq_ready_t *rq = ready;
+    if (level >= rq->num_levels) return -1;
+    rq->quanta[level] = quantum_ms;
+    return 0;
+}
+
+const scheduler_policy_t mlfq_policy = {
+    .name = "MLFQ",
+    .init = mlfq_policy_init,
+    .enqueue = mlfq_policy_enqueue,
+    .tick = mlfq_tick,
+    .pick = mlfq_pick,
+    .ready_count = mlfq_ready_count,
+    .quantum_ms = mlfq_quantum_ms,
+    .destroy = free,
+    .level_counts = mlfq_level_counts,
+    .set_quantum = mlfq_set_quantum,
+};
@@ -1,27 +1,60 @@
 #ifndef MLFQ_H
 #define MLFQ_H
 
+#include "policy.h"
 #include "queue.h"
 #include "msg.h"
 
-#define NUM_MLFQ_LEVELS 3
+#define MAX_MLFQ_LEVELS 64          // Limited by the width of the non-empty bitmap
 
 typedef struct {
-    queue_t levels[NUM_MLFQ_LEVELS];
-    uint32_t quanta[NUM_MLFQ_LEVELS];
+    queue_t levels[MAX_MLFQ_LEVELS];
+    uint32_t quanta[MAX_MLFQ_LEVELS];
+    uint32_t num_levels;            // Number of levels in use
+    uint64_t non_empty;             // Bit l is set when levels[l] holds at least one task
 } mlfq_ready_t;
 
+/**
+ * @brief Initializes the MLFQ ready queues.
+ *
+ * @param rq Pointer to the MLFQ ready queues.
+ * @param num_levels Number of levels, between 1 and MAX_MLFQ_LEVELS.
+ * @param quanta Quantum in milliseconds of each level, level 0 first.
+ * @return 0 on success, -1 if the number of levels is out of range.
+ */
+int mlfq_init(mlfq_ready_t *rq, uint32_t num_levels, const uint32_t *quanta);
+
+/**
+ * @brief Parses a comma-separated list of quanta, e.g. "8,16,1000000", one per level.
+ *
+ * @return Number of levels parsed, or -1 on a malformed list.
+ */
+int mlfq_parse_quanta(const char *list, uint32_t *quanta);
+
+/**
+ * @brief Reads the quanta from a file with one quantum per line ('#' starts a comment).
+ *
+ * @return Number of levels read, or -1 on error.
+ */
+int mlfq_read_quanta_file(const char *filename, uint32_t *quanta);
+
+/**
+ * @brief Adds a task to the given level, keeping the non-empty bitmap up to date.
+ */
+int mlfq_enqueue(mlfq_ready_t *rq, uint32_t level, pcb_t *task);
+
 /**
  * @brief Multi-Level Feedback Queue (MLFQ) scheduling algorithm.
  *
- * Implements MLFQ with 3 levels:
+ * Implements MLFQ with a configurable number of levels, by default 3:
  * - Level 0: High priority, short quantum (8 ms)
  * - Level 1: Medium priority, medium quantum (16 ms)
  * - Level 2: Low priority, long quantum (non-preemptive effectively)
  *
  * New tasks or post-I/O start at level 0.
  * Exhausted quantum demotes to next level.
- * Selects from highest non-empty level (FIFO within level).
+ * Selects from highest non-empty level (FIFO within level), found with a single
+ * find-first-set on the non-empty bitmap.
  *
  * @param current_time_ms The current time in milliseconds.
  * @param rq Pointer to the MLFQ ready queues.
@@ -29,4 +62,6 @@ typedef struct {
  */
 void mlfq_scheduler(uint32_t current_time_ms, mlfq_ready_t *rq, pcb_t **cpu_task);
 
-#endif // MLFQ_H
\ No newline at end of file
+extern const scheduler_policy_t mlfq_policy;
+
+#endif // MLFQ_H
@@ -10,6 +10,7 @@
 #include <sys/types.h>
 
 #define SOCKET_PATH "/tmp/scheduler.sock"
+#define CONTROL_SOCKET_PATH "/tmp/scheduler-control.sock"  // Statistics and control, see control.h
 
 #define MAX_PAGES 32
 
@@ -18,7 +19,8 @@ static const char PROCESS_REQUEST_STRINGS[][10] = {
     "RUN",
     "BLOCK",
     "ACK",
-    "DONE"
+    "DONE",
+    "SUBMIT"
 };
 
 // Define the types of requests a process can make to the scheduler
@@ -27,8 +29,19 @@ typedef enum  {
     PROCESS_REQUEST_BLOCK,
     PROCESS_REQUEST_ACK,
     PROCESS_REQUEST_DONE,
+    PROCESS_REQUEST_SUBMIT,         // time_ms holds the number of burst_msg_t that follow the message
 } process_request_t;
 
+#define MAX_SUBMIT_BURSTS 65536
+
+// One burst of a SUBMIT request. The simulator runs the bursts (and their blocks) one after
+// the other without talking to the application, which gets an ACK when the bursts are
+// accepted and a single DONE when the last one is over.
+typedef struct burst_msg_st {
+    uint32_t burst_time_ms;         // CPU time of the burst
+    uint32_t block_time_ms;         // I/O wait after the burst, 0 for none
+} burst_msg_t;
+
 // Define the structure for page information
 // Note: Not used until we get to memory management, but defined here for completeness
 typedef struct {
@@ -1,298 +1,702 @@
 #include <stdio.h>
-#include <sys/socket.h>
-#include <sys/un.h>
-#include <fcntl.h>
 #include <unistd.h>
 #include <string.h>
-#include "sjf.h"
 #include "debug.h"
-
-#define MAX_CLIENTS 128
-
 #include <stdlib.h>
-#include <sys/errno.h>
-
-#include "fifo.h"
+#include <getopt.h>
+#include <signal.h>
+
+#include "batch.h"
+#include "control.h"
+#include "event_queue.h"
+#include "histogram.h"
+#include "io_thread.h"
+#include "machine.h"
+#include "metrics.h"
 #include "mlfq.h"
 #include "msg.h"
+#include "pacer.h"
+#include "policy.h"
 #include "queue.h"
+#include "RR.h"
+#include "timer_wheel.h"
+#include "trace.h"
+#include "transport.h"
 #define SJF_C
 #define SJF_H
 
+#define EVENT_GRACE_MS TICKS_MS     // Real time the event engine waits for clients before skipping ahead
 
 
-static uint32_t PID = 0;
 
-typedef enum  {
-    NULL_SCHEDULER = -1,
-    SCHED_FIFO = 0,
-    SCHED_SJF = 1,
-    SCHED_RR = 2,
-    SCHED_MLFQ = 3
+static metrics_t metrics = {0};
+static volatile sig_atomic_t stop_requested = 0;
+static volatile sig_atomic_t metrics_requested = 0;
 
-} scheduler_en;
+// Connections to the applications, see io_thread.h
+static io_thread_t io;
 
-int setup_server_socket(const char *socket_path) {
-    int server_fd;
-    struct sockaddr_un addr;
+// Real-time pacing of the ticks, unless the engine runs as fast as it can
+static pacer_t pacer;
+static int paced = 0;
 
-    unlink(socket_path);
+// Wall time from the reading of a request by the I/O thread to its handling at the next tick
+static histogram_t request_latency[PROCESS_REQUEST_SUBMIT + 1];
 
-    if ((server_fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
-        perror("socket");
-        return -1;
+// Statistics and control socket, see control.h
+static control_t control;
+static int paused = 0;                      // Clock stopped from the control socket
+
+/**
+ * @brief Wall time at which the current tick was due: its deadline minus a period when paced.
+ *
+ * Without pacing (--event, --speed max) simulated and real time are unrelated, and a DONE is due
+ * when the scheduler finds out the burst or block is over, that is now.
+ */
+static uint64_t tick_due_ns(void) {
+    return paced ? pacer.deadline_ns - pacer.period_ns : monotonic_ns();
+}
+
+/**
+ * @brief Done handler of the policies: tells the application that its CPU burst is over.
+ *
+ * Tasks with submitted bursts are only told when the last of them is over.
+ */
+static void send_done(pcb_t *task, uint32_t current_time_ms) {
+    if (!task->workload) {
+        io_send(&io, task, PROCESS_REQUEST_DONE, current_time_ms, IO_LATENCY_RUN_DONE, tick_due_ns());
     }
+}
 
-    memset(&addr, 0, sizeof(struct sockaddr_un));
-    addr.sun_family = AF_UNIX;
-    strncpy(addr.sun_path, SOCKET_PATH, sizeof(addr.sun_path) - 1);
+/**
+ * @brief Puts a task back in the command queue, where it waits for the next request.
+ */
+static void enqueue_command(queue_t *command_queue, pcb_t *pcb) {
+    pcb->status = TASK_COMMAND;
+    enqueue_pcb(command_queue, pcb);
+    io_watch(&io, pcb);
+}
 
-    if (bind(server_fd, (struct sockaddr *) &addr, sizeof(struct sockaddr_un)) < 0) {
-        perror("bind");
-        close(server_fd);
-        return -1;
+/**
+ * @brief Drops a client that disconnected or misbehaved. The task must be in the command queue.
+ */
+static void close_client(queue_t *command_queue, pcb_t *pcb) {
+    free_queue_elem(remove_queue_pcb(command_queue, pcb));
+    metrics_task_exit(&metrics, pcb);
+    free(pcb->workload);
+    io_close(&io, pcb);         // The I/O thread closes the connection and frees the task
+}
+
+/**
+ * @brief Puts the current submitted burst of a task in the ready queue, as a RUN request would.
+ */
+static void run_workload_burst(pcb_t *pcb, machine_t *machine,
+                               const timer_wheel_t *blocked_queue, uint32_t current_time_ms) {
+    pcb->time_ms = pcb->workload[pcb->workload_pos].burst_time_ms;
+    pcb->ellapsed_time_ms = 0;
+    pcb->status = TASK_RUNNING;
+    metrics_burst_arrival(&metrics, pcb, current_time_ms);
+    machine_enqueue(machine, pcb);
+    trace_event(TRACE_ENQUEUE, current_time_ms, pcb, pcb->time_ms,
+                machine_ready_count(machine), blocked_queue->count);
+}
+
+/**
+ * @brief Moves a task with submitted bursts to its next phase without a round trip to the application.
+ *
+ * Called when the CPU burst of the task is done (block_done = 0) or when its I/O wait is over
+ * (block_done = 1). The block, or the next burst, starts at the current time: there is no tick
+ * lost waiting for the application's next request. After the last burst the application gets
+ * its DONE and the task goes back to the command queue for another SUBMIT.
+ */
+static void advance_workload(pcb_t *pcb, int block_done, queue_t *command_queue, timer_wheel_t *blocked_queue,
+                             machine_t *machine, event_queue_t *events,
+                             uint32_t current_time_ms) {
+    const burst_msg_t *burst = &pcb->workload[pcb->workload_pos];
+    if (!block_done && burst->block_time_ms > 0) {
+        pcb->time_ms = burst->block_time_ms;
+        pcb->status = TASK_BLOCKED;
+        uint32_t ticks = (burst->block_time_ms + TICKS_MS - 1) / TICKS_MS;
+        pcb->wake_time_ms = current_time_ms + ticks * TICKS_MS;
+        timer_wheel_add(blocked_queue, pcb);
+        trace_event(TRACE_BLOCK, current_time_ms, pcb, pcb->wake_time_ms,
+                    machine_ready_count(machine), blocked_queue->count);
+        if (events) {
+            push_event(events, pcb->wake_time_ms, EVENT_BLOCK_EXPIRED, pcb);
+        }
+        return;
     }
 
-    if (listen(server_fd, MAX_CLIENTS) < 0) {
-        perror("listen");
-        close(server_fd);
-        return -1;
+    if (++pcb->workload_pos < pcb->workload_len) {
+        run_workload_burst(pcb, machine, blocked_queue, current_time_ms);
+        return;
     }
 
-    int flags = fcntl(server_fd, F_GETFL, 0);
-    if (flags != -1) {
-        if (fcntl(server_fd, F_SETFL, flags | O_NONBLOCK) == -1) {
-            perror("fcntl: set non-blocking");
+    free(pcb->workload);
+    pcb->workload = NULL;
+    io_send(&io, pcb, PROCESS_REQUEST_DONE, current_time_ms, IO_LATENCY_SUBMIT_DONE, tick_due_ns());
+    DBG("Process %d finished its submitted bursts, sending DONE\n", pcb->pid);
+    enqueue_command(command_queue, pcb);
+}
+
+/**
+ * @brief Handles a request read by the I/O thread for a task in the command queue.
+ */
+static void handle_client_message(pcb_t *current_pcb, msg_t msg, burst_msg_t *workload, uint64_t received_ns,
+                                  queue_t *command_queue, timer_wheel_t *blocked_queue, machine_t *machine,
+                                  uint32_t current_time_ms, event_queue_t *events) {
+    io_latency_en ack_latency = IO_LATENCY_RUN_ACK;
+    if (msg.request == PROCESS_REQUEST_RUN || msg.request == PROCESS_REQUEST_BLOCK ||
+        msg.request == PROCESS_REQUEST_SUBMIT) {
+        free_queue_elem(remove_queue_pcb(command_queue, current_pcb));
+    }
+    if (msg.request == PROCESS_REQUEST_RUN) {
+        current_pcb->pid = msg.pid;
+        current_pcb->time_ms = msg.time_ms;
+        current_pcb->ellapsed_time_ms = 0;
+        current_pcb->status = TASK_RUNNING;
+        metrics_burst_arrival(&metrics, current_pcb, current_time_ms);
+        machine_enqueue(machine, current_pcb);
+        trace_event(TRACE_ENQUEUE, current_time_ms, current_pcb, current_pcb->time_ms,
+                    machine_ready_count(machine), blocked_queue->count);
+        DBG("Process %d requested RUN for %d ms\n", current_pcb->pid, current_pcb->time_ms);
+    } else if (msg.request == PROCESS_REQUEST_BLOCK) {
+        current_pcb->pid = msg.pid;
+        current_pcb->time_ms = msg.time_ms;
+        current_pcb->status = TASK_BLOCKED;
+        // The current tick already counts as blocked time, so the task wakes one tick early
+        uint32_t ticks = (msg.time_ms + TICKS_MS - 1) / TICKS_MS;
+        current_pcb->wake_time_ms = current_time_ms + (ticks > 0 ? ticks - 1 : 0) * TICKS_MS;
+        timer_wheel_add(blocked_queue, current_pcb);
+        trace_event(TRACE_BLOCK, current_time_ms, current_pcb, current_pcb->wake_time_ms,
+                    machine_ready_count(machine), blocked_queue->count);
+        if (events) {
+            push_event(events, current_pcb->wake_time_ms, EVENT_BLOCK_EXPIRED, current_pcb);
         }
+        ack_latency = IO_LATENCY_BLOCK_ACK;
+        DBG("Process %d requested BLOCK for %d ms\n", current_pcb->pid, current_pcb->time_ms);
+    } else if (msg.request == PROCESS_REQUEST_SUBMIT) {
+        current_pcb->pid = msg.pid;
+        current_pcb->workload = workload;
+        current_pcb->workload_len = msg.time_ms;
+        current_pcb->workload_pos = 0;
+        run_workload_burst(current_pcb, machine, blocked_queue, current_time_ms);
+        ack_latency = IO_LATENCY_SUBMIT_ACK;
+        DBG("Process %d submitted %u bursts\n", current_pcb->pid, msg.time_ms);
+    } else {
+        printf("Unexpected message received from client\n");
+        io_watch(&io, current_pcb);
+        return;
     }
-    return server_fd;
+
+    histogram_record(&request_latency[msg.request], monotonic_ns() - received_ns);
+    io_send(&io, current_pcb, PROCESS_REQUEST_ACK, current_time_ms, ack_latency, received_ns);
+    trace_event(TRACE_ACK, current_time_ms, current_pcb, msg.time_ms,
+                machine_ready_count(machine), blocked_queue->count);
+    DBG("Send ACK message to process %d with time %d\n", current_pcb->pid, current_time_ms);
+}
+
+/**
+ * @brief Prints the metrics table, with the CPUs and the pacing when they apply.
+ */
+static void print_all_metrics(const machine_t *machine, FILE *out) {
+    print_metrics(&metrics, out);
+    print_cpu_stats(machine, &metrics, out);
+    if (paced) print_pacer_stats(&pacer, out);
+}
+
+/**
+ * @brief Copies the queue lengths, the running tasks and the counters for the stats command.
+ */
+static void take_snapshot(control_snapshot_t *s, const queue_t *command_queue, const timer_wheel_t *blocked_queue,
+                          const machine_t *machine, uint32_t current_time_ms) {
+    s->policy = machine->policy->name;
+    s->num_cpus = machine->num_cpus;
+    s->num_levels = machine_level_counts(machine, s->ready);
+    for (uint32_t l = 0; l < s->num_levels; l++) {
+        pcb_t probe = { .level = (uint8_t)l };      // quantum_ms() only looks at the level
+        s->quanta[l] = machine->policy->quantum_ms(machine->cpus[0].rq, &probe);
+    }
+    s->blocked = blocked_queue->count;
+    s->waiting = command_queue->count;
+    for (uint32_t c = 0; c < machine->num_cpus; c++) {
+        const cpu_t *cpu = &machine->cpus[c];
+        s->running[c] = cpu->task ? cpu->task->pid : -1;
+        s->busy_ms[c] = cpu->busy_ms + (cpu->task ? current_time_ms - cpu->dispatch_ms : 0);
+    }
+    s->started = metrics.started;
+    s->first_arrival_ms = metrics.first_arrival_ms;
+    s->bursts = metrics.num_bursts;
+    s->tasks = metrics.num_tasks;
+    s->context_switches = metrics.context_switches;
+    s->paced = paced;
+    s->ticks = pacer.ticks;
+    s->late = pacer.late;
 }
 
-void check_new_commands(queue_t *command_queue, queue_t *blocked_queue, void *ready_queue, int server_fd, uint32_t current_time_ms, scheduler_en scheduler_type) {
-    int client_fd;
-    do {
-        client_fd = accept(server_fd, NULL, NULL);
-        if (client_fd < 0) {
-            if (errno == EMFILE || errno == ENFILE) {
-                perror("accept: too many fds");
+/**
+ * @brief Executes a command of the control socket and answers it.
+ */
+static void handle_control(control_request_t *request, const queue_t *command_queue,
+                           const timer_wheel_t *blocked_queue, machine_t *machine, uint32_t current_time_ms) {
+    switch (request->command) {
+        case CONTROL_STATS:
+            take_snapshot(&request->snapshot, command_queue, blocked_queue, machine, current_time_ms);
+            break;
+        case CONTROL_METRICS: {
+            FILE *out = open_memstream(&request->text, &request->text_len);
+            if (!out) {
+                request->error = "out of memory";
                 break;
             }
-            if (errno == EINTR)        continue;
-            if (errno == ECONNABORTED) continue;
-            if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
-                perror("accept");
-            }
+            print_all_metrics(machine, out);
+            fclose(out);
             break;
         }
-        int flags = fcntl(client_fd, F_GETFL, 0);
-        if (flags != -1) {
-            if (fcntl(client_fd, F_SETFL, flags | O_NONBLOCK) == -1) {
-                perror("fcntl: set non-blocking");
-            }
-        }
-        int fdflags = fcntl(client_fd, F_GETFD, 0);
-        if (fdflags != -1) {
-            fcntl(client_fd, F_SETFD, fdflags | FD_CLOEXEC);
-        }
-        DBG("[Scheduler] New client connected: fd=%d\n", client_fd);
-        pcb_t *pcb = new_pcb(++PID, client_fd, 0);
-        enqueue_pcb(command_queue, pcb);
-    } while (client_fd > 0);
-
-    queue_elem_t * elem = command_queue->head;
-    while (elem != NULL) {
-        pcb_t *current_pcb = elem->pcb;
-        msg_t msg;
-        int n = read(current_pcb->sockfd, &msg, sizeof(msg_t));
-        if (n <= 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                elem = elem->next;
-            } else {
-                if (n < 0) {
-                    perror("read");
-                } else {
-                    DBG("Connection closed by remote host\n");
-                }
-                queue_elem_t *tmp = elem;
-                elem = elem->next;
-                free(current_pcb);
-                free(tmp);
-            }
-            continue;
-        }
-        if (msg.request == PROCESS_REQUEST_RUN) {
-            current_pcb->pid = msg.pid;
-            current_pcb->time_ms = msg.time_ms;
-            current_pcb->ellapsed_time_ms = 0;
-            current_pcb->status = TASK_RUNNING;
-            if (scheduler_type == SCHED_MLFQ) {
-                current_pcb->level = 0;
-            }
-            if (scheduler_type == SCHED_MLFQ) {
-                enqueue_pcb(&((mlfq_ready_t *)ready_queue)->levels[0], current_pcb);
-            } else {
-                enqueue_pcb((queue_t *)ready_queue, current_pcb);
+        case CONTROL_PAUSE:
+            paused = 1;
+            break;
+        case CONTROL_RESUME:
+            if (paused && paced) pacer_restart(&pacer);
+            paused = 0;
+            break;
+        case CONTROL_QUANTUM:
+            if (machine_set_quantum(machine, request->level, request->quantum_ms) < 0) {
+                request->error = machine->policy->set_quantum ? "no such level" : "the policy has no quantum";
             }
-            DBG("Process %d requested RUN for %d ms\n", current_pcb->pid, current_pcb->time_ms);
-        } else if (msg.request == PROCESS_REQUEST_BLOCK) {
-            current_pcb->pid = msg.pid;
-            current_pcb->time_ms = msg.time_ms;
-            current_pcb->status = TASK_BLOCKED;
-            enqueue_pcb(blocked_queue, current_pcb);
-            DBG("Process %d requested BLOCK for %d ms\n", current_pcb->pid);
-        } else {
-            printf("Unexpected message received from client\n");
-            continue;
-        }
-        remove_queue_elem(command_queue, elem);
-        queue_elem_t *tmp = elem;
-        elem = elem->next;
-        free(tmp);
-
-        msg_t ack_msg = {
-            .pid = current_pcb->pid,
-            .request = PROCESS_REQUEST_ACK,
-            .time_ms = current_time_ms
-        };
-        if (write(current_pcb->sockfd, &ack_msg, sizeof(msg_t)) != sizeof(msg_t)) {
-            perror("write");
-        }
-        DBG("Send ACK message to process %d with time %d\n", current_pcb->pid, current_time_ms);
+            break;
     }
+    request->time_ms = current_time_ms;
+    request->paused = paused;
+    control_answer(request);
 }
 
-void check_blocked_queue(queue_t * blocked_queue, queue_t * command_queue, uint32_t current_time_ms) {
-    queue_elem_t * elem = blocked_queue->head;
-    while (elem != NULL) {
-        pcb_t *pcb = elem->pcb;
-        if (pcb->time_ms > TICKS_MS) {
-            pcb->time_ms -= TICKS_MS;
-        } else {
-            pcb->time_ms = 0;
+/**
+ * @brief Takes the new connections, requests and disconnections handed over by the I/O thread.
+ *
+ * The I/O thread reads at most one request per task and then waits for io_watch(), which
+ * enqueue_command() calls once the task may talk to the scheduler again, so every request
+ * belongs to a task in the command queue.
+ */
+void check_new_commands(queue_t *command_queue, timer_wheel_t *blocked_queue, machine_t *machine, uint32_t current_time_ms, event_queue_t *events) {
+    io_event_t event;
+    while (io_poll_event(&io, &event)) {
+        switch (event.type) {
+            case IO_EVENT_CONNECTED:
+                enqueue_pcb(command_queue, event.pcb);
+                break;
+            case IO_EVENT_MESSAGE:
+                handle_client_message(event.pcb, event.msg, event.workload, event.received_ns, command_queue,
+                                      blocked_queue, machine, current_time_ms, events);
+                break;
+            case IO_EVENT_CLOSED:
+                close_client(command_queue, event.pcb);
+                break;
+            case IO_EVENT_CONTROL:
+                handle_control(event.control, command_queue, blocked_queue, machine, current_time_ms);
+                break;
         }
-        if (pcb->time_ms == 0) {
-            msg_t msg = {
-                .pid = pcb->pid,
-                .request = PROCESS_REQUEST_DONE,
-                .time_ms = current_time_ms
-            };
-            if (write(pcb->sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
-                perror("write");
-            }
-            DBG("Process %d finished BLOCK, sending DONE\n", pcb->pid);
-            pcb->status = TASK_COMMAND;
-            enqueue_pcb(command_queue, pcb);
-
-            remove_queue_elem(blocked_queue, elem);
-            queue_elem_t *tmp = elem;
-            elem = elem->next;
-            free(tmp);
-        } else {
-            elem = elem->next;
+    }
+}
+
+/**
+ * @brief Wakes up the blocked tasks whose I/O wait ends at the current tick.
+ *
+ * Blocked tasks sit in a timing wheel keyed on their wake-up time, so only the tasks
+ * expiring now are visited, regardless of how many tasks are blocked.
+ */
+void check_blocked_queue(timer_wheel_t * blocked_queue, queue_t * command_queue, uint32_t current_time_ms,
+                         machine_t *machine, event_queue_t *events) {
+    queue_t expired = {.head = NULL, .tail = NULL};
+    timer_wheel_expire(blocked_queue, current_time_ms, &expired);
+
+    pcb_t *pcb;
+    while ((pcb = dequeue_pcb(&expired)) != NULL) {
+        if (pcb->workload) {
+            trace_event(TRACE_WAKE, current_time_ms, pcb, 0, machine_ready_count(machine), blocked_queue->count);
+            advance_workload(pcb, 1, command_queue, blocked_queue, machine, events, current_time_ms);
+            continue;
         }
+        io_send(&io, pcb, PROCESS_REQUEST_DONE, current_time_ms, IO_LATENCY_BLOCK_DONE, tick_due_ns());
+        DBG("Process %d finished BLOCK, sending DONE\n", pcb->pid);
+        trace_event(TRACE_WAKE, current_time_ms, pcb, 0, machine_ready_count(machine), blocked_queue->count);
+        enqueue_command(command_queue, pcb);
     }
 }
 
-static const char *SCHEDULER_NAMES[] = {
-    "FIFO",
-    "SJF",
-    "RR",
-    "MLFQ",
-    NULL
-};
+/**
+ * @brief Discrete-event replacement for the fixed sleep at the end of each tick.
+ *
+ * Instead of sleeping TICKS_MS and processing the next tick, the engine looks at the earliest
+ * pending event (burst completion, quantum expiry or block expiry) and jumps the clock straight
+ * to it. The ticks in between cannot change any state, so their only effect, the accounting of
+ * running time, is applied in bulk. Blocked tasks carry absolute wake-up times and need nothing.
+ * Messages from clients are not known in advance: if a client has something pending, the clock
+ * only moves one tick forward, exactly like the tick-based loop. When nothing at all is pending
+ * the process sleeps until a client talks.
+ *
+ * The CPU events are recomputed from the state of every CPU on each call, the heap only holds
+ * block expiries. Those are invalidated lazily: a stale event just causes an ordinary tick where
+ * nothing happens, which is harmless.
+ *
+ * @return The new simulation time.
+ */
+static uint32_t advance_to_next_event(event_queue_t *events, machine_t *machine,
+                                      const queue_t *command_queue, uint32_t current_time_ms) {
+    event_t ev;
+    while (peek_event(events) && peek_event(events)->time_ms <= current_time_ms) {
+        pop_event(events, &ev);
+    }
+
+    uint32_t next_ms = machine_next_event_ms(machine, current_time_ms);
+    if (peek_event(events) && peek_event(events)->time_ms < next_ms) {
+        next_ms = peek_event(events)->time_ms;
+    }
 
+    int timeout_ms = 0;
+    if (next_ms == UINT32_MAX) {
+        timeout_ms = -1;                        // Nothing will ever happen without a client
+    } else if (command_queue->head) {
+        timeout_ms = EVENT_GRACE_MS;            // Give clients that just got DONE/ACK time to answer
+    }
+    if ((timeout_ms != 0 || next_ms > current_time_ms + TICKS_MS) &&
+        io_wait_event(&io, timeout_ms) != 0) {
+        next_ms = current_time_ms + TICKS_MS;
+    }
 
+    // Account for the ticks that are skipped
+    uint32_t skipped_ms = next_ms - current_time_ms - TICKS_MS;
+    if (skipped_ms > 0) {
+        machine_skip(machine, skipped_ms);
+    }
+    return next_ms;
+}
 
-scheduler_en get_scheduler(const char *name) {
-    printf("DEBUG: Argumento recebido: '%s'\n", name); // Adicionado para depuração
-    for (int i = 0; SCHEDULER_NAMES[i] != NULL; i++) {
-        if (strcmp(name, SCHEDULER_NAMES[i]) == 0) {
-            return (scheduler_en)i;
-        }
+/**
+ * @brief Replaces the sleep between ticks when the clock runs as fast as the clients keep up (--speed max).
+ *
+ * The next tick starts at once, unless a task waits for the next request of its application: the
+ * simulator then gives the client up to EVENT_GRACE_MS to answer, as the event engine does, so a
+ * live client never sees the clock run away between two of its requests. With no task ready,
+ * running or blocked, nothing can happen before a client talks and the simulator sleeps until one does.
+ */
+static void keep_up_with_clients(const queue_t *command_queue, const timer_wheel_t *blocked_queue,
+                                 const machine_t *machine, uint32_t current_time_ms) {
+    if (command_queue->head) {
+        io_wait_event(&io, EVENT_GRACE_MS);
+    } else if (blocked_queue->count == 0 && machine_next_event_ms(machine, current_time_ms) == UINT32_MAX) {
+        io_wait_event(&io, -1);
     }
+}
+
+/**
+ * @brief Prints the wall-time latency of the protocol: how long requests wait for a tick, and how
+ * long until the ACK or DONE is written. The I/O thread must be stopped.
+ */
+static void print_latency(FILE *out) {
+    print_histogram_header(out, "Message latency (us, wall time)");
+    print_histogram_line(out, "RUN received to handled", &request_latency[PROCESS_REQUEST_RUN]);
+    print_histogram_line(out, "BLOCK received to handled", &request_latency[PROCESS_REQUEST_BLOCK]);
+    print_histogram_line(out, "SUBMIT received to handled", &request_latency[PROCESS_REQUEST_SUBMIT]);
+    print_io_latency(&io, out);
+}
+
+static void handle_signal(int sig) {
+    if (sig == SIGUSR1) {
+        metrics_requested = 1;
+    } else {
+        stop_requested = 1;
+    }
+}
+
+/**
+ * @brief Installs the handlers that stop the simulator (SIGINT, SIGTERM) or print its metrics (SIGUSR1).
+ *
+ * SA_RESTART is left out on purpose, so that a signal interrupts the sleep between ticks.
+ * SIGPIPE is ignored: writing to a client that went away must not kill the simulator.
+ */
+static void setup_signals(void) {
+    struct sigaction sa = {0};
+    sa.sa_handler = handle_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGUSR1, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);       // A client that went away shows up as EPIPE and then EOF
+}
+
+const scheduler_policy_t *get_scheduler(const char *name) {
+    const scheduler_policy_t *policy = find_policy(name);
+    if (policy) return policy;
+
     printf("Scheduler %s not recognized. Available options are:\n", name);
-    for (int i = 0; SCHEDULER_NAMES[i] != NULL; i++) {
-        printf(" - %s\n", SCHEDULER_NAMES[i]);
+    for (int i = 0; SCHEDULER_POLICIES[i] != NULL; i++) {
+        printf(" - %s\n", SCHEDULER_POLICIES[i]->name);
     }
-    return NULL_SCHEDULER;
+    return NULL;
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options] <scheduler>\nScheduler options: FIFO SJF RR MLFQ\n", prog);
+    printf("  -b, --batch SCENARIO     run the applications of SCENARIO in-process, without sockets\n");
+    printf("  -e, --event              discrete-event engine: jump to the next event instead of sleeping every tick\n");
+    printf("  -s, --speed N            run the clock N times faster than wall time, or \"max\" to run it as fast\n"
+           "                           as the applications keep up (default 1)\n");
+    printf("  -S, --spin               spin the end of each tick instead of sleeping, for short ticks at high speeds\n");
+    printf("  -n, --cpus N             simulate N CPUs, each with its own ready queue (default 1)\n");
+    printf("  -l, --backlog N          listen backlog of the socket (default %d)\n", DEFAULT_BACKLOG);
+    printf("  -m, --shm                talk to the applications through shared memory (%s) instead of the socket\n", SHM_PATH);
+    printf("  -q, --mlfq-quanta LIST   MLFQ quanta in ms, one per level (default 8,16,1000000)\n");
+    printf("  -c, --mlfq-config FILE   read the MLFQ quanta from FILE, one per line\n");
+    printf("  -r, --rr-quantum MS      Round-Robin time slice in ms (default %d)\n", QUANTUM_MS);
+    printf("  -t, --trace FILE         record every scheduling decision in FILE (read it with trace_dump)\n");
+    printf("  -T, --trace-records N    size of the trace ring in records (default %u)\n", TRACE_DEFAULT_RECORDS);
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        printf("Usage: %s <scheduler>\nScheduler options: FIFO SJF RR MLFQ\n", argv[0]);
+    int event_mode = 0;
+    double speed = 1.0;                     // Simulated ms per real ms, 0 for no pacing
+    pacer_mode_en pacer_mode = PACER_SLEEP;
+    transport_en transport = TRANSPORT_SOCKET;
+    const char *batch_scenario = NULL;
+    const char *trace_file = NULL;
+    uint32_t trace_records = TRACE_DEFAULT_RECORDS;
+    uint32_t mlfq_quanta[MAX_MLFQ_LEVELS] = {8, 16, 1000000};
+    int mlfq_levels = 3;
+    uint32_t rr_quantum_ms = QUANTUM_MS;
+    uint32_t num_cpus = 1;
+    int backlog = DEFAULT_BACKLOG;
+
+    static const struct option long_options[] = {
+        {"batch", required_argument, NULL, 'b'},
+        {"event", no_argument, NULL, 'e'},
+        {"speed", required_argument, NULL, 's'},
+        {"spin", no_argument, NULL, 'S'},
+        {"cpus", required_argument, NULL, 'n'},
+        {"backlog", required_argument, NULL, 'l'},
+        {"shm", no_argument, NULL, 'm'},
+        {"mlfq-quanta", required_argument, NULL, 'q'},
+        {"mlfq-config", required_argument, NULL, 'c'},
+        {"rr-quantum", required_argument, NULL, 'r'},
+        {"trace", required_argument, NULL, 't'},
+        {"trace-records", required_argument, NULL, 'T'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "b:el:mn:q:c:r:s:St:T:", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'b':
+                batch_scenario = optarg;
+                break;
+            case 'e':
+                event_mode = 1;
+                break;
+            case 's': {
+                if (strcmp(optarg, "max") == 0) {
+                    speed = 0;
+                    break;
+                }
+                char *endptr;
+                speed = strtod(optarg, &endptr);
+                if (endptr == optarg || *endptr != '\0' || !(speed > 0) || speed > 1e6) {
+                    fprintf(stderr, "Invalid speed: %s (a factor up to 1000000, or max)\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            }
+            case 'S':
+                pacer_mode = PACER_SPIN;
+                break;
+            case 'l': {
+                char *endptr;
+                long value = strtol(optarg, &endptr, 10);
+                if (*endptr != '\0' || value <= 0 || value > INT32_MAX) {
+                    fprintf(stderr, "Invalid backlog: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                backlog = (int)value;
+                break;
+            }
+            case 'm':
+                transport = TRANSPORT_SHM;
+                break;
+            case 'n': {
+                char *endptr;
+                long value = strtol(optarg, &endptr, 10);
+                if (*endptr != '\0' || value <= 0 || value > MAX_CPUS) {
+                    fprintf(stderr, "Invalid number of CPUs: %s (1 to %d)\n", optarg, MAX_CPUS);
+                    exit(EXIT_FAILURE);
+                }
+                num_cpus = (uint32_t)value;
+                break;
+            }
+            case 'q':
+                mlfq_levels = mlfq_parse_quanta(optarg, mlfq_quanta);
+                if (mlfq_levels <= 0) {
+                    fprintf(stderr, "Invalid MLFQ quanta: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'c':
+                mlfq_levels = mlfq_read_quanta_file(optarg, mlfq_quanta);
+                if (mlfq_levels <= 0) {
+                    fprintf(stderr, "Failed to read MLFQ quanta from %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'r': {
+                char *endptr;
+                long value = strtol(optarg, &endptr, 10);
+                if (*endptr != '\0' || value <= 0 || value > UINT32_MAX) {
+                    fprintf(stderr, "Invalid RR quantum: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                rr_quantum_ms = (uint32_t)value;
+                break;
+            }
+            case 't':
+                trace_file = optarg;
+                break;
+            case 'T': {
+                char *endptr;
+                long value = strtol(optarg, &endptr, 10);
+                if (*endptr != '\0' || value <= 0 || value > (1L << 31)) {
+                    fprintf(stderr, "Invalid trace size: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                trace_records = (uint32_t)value;
+                break;
+            }
+            default:
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (optind != argc - 1) {
+        print_usage(argv[0]);
         exit(EXIT_FAILURE);
     }
 
-    scheduler_en scheduler_type = get_scheduler(argv[1]);
-    if (scheduler_type == NULL_SCHEDULER) {
+    if ((event_mode || batch_scenario) && speed != 1.0) {
+        fprintf(stderr, "--speed only applies to the tick-based engine, ignored\n");
+    }
+
+    const scheduler_policy_t *policy = get_scheduler(argv[optind]);
+    if (policy == NULL) {
         return EXIT_FAILURE;
     }
 
     queue_t command_queue = {.head = NULL, .tail = NULL};
-    queue_t blocked_queue = {.head = NULL, .tail = NULL};
-
-    void *ready_ptr = NULL;
-    queue_t single_ready_queue = {.head = NULL, .tail = NULL};
-    mlfq_ready_t mlfq_ready_queue = {0};
-    if (scheduler_type == SCHED_MLFQ) {
-        mlfq_ready_queue.quanta[0] = 8;
-        mlfq_ready_queue.quanta[1] = 16;
-        mlfq_ready_queue.quanta[2] = 1000000;
-        for (int i = 0; i < NUM_MLFQ_LEVELS; i++) {
-            mlfq_ready_queue.levels[i].head = NULL;
-            mlfq_ready_queue.levels[i].tail = NULL;
-        }
-        ready_ptr = &mlfq_ready_queue;
-    } else {
-        single_ready_queue.head = NULL;
-        single_ready_queue.tail = NULL;
-        ready_ptr = &single_ready_queue;
+    static timer_wheel_t blocked_queue = {0};
+
+    policy_config_t config = {
+        .rr_quantum_ms = rr_quantum_ms,
+        .mlfq_levels = (uint32_t)mlfq_levels,
+        .mlfq_quanta = mlfq_quanta,
+    };
+    if (trace_file && trace_open(trace_file, trace_records) < 0) {
+        return EXIT_FAILURE;
     }
+    if (batch_scenario) {
+        int ret = run_batch(batch_scenario, policy, &config, num_cpus);
+        trace_close();
+        return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    static machine_t machine;
+    if (machine_init(&machine, policy, &config, num_cpus) < 0) {
+        fprintf(stderr, "Failed to initialize the %s scheduler\n", policy->name);
+        return EXIT_FAILURE;
+    }
+    metrics.num_cpus = num_cpus;
 
-    pcb_t *CPU = NULL;
-    pcb_t *prev_CPU = NULL;
-
-    int server_fd = setup_server_socket(SOCKET_PATH);
-    if (server_fd < 0) {
-        fprintf(stderr, "Failed to set up server socket\n");
+    raise_fd_limit();
+    if (io_thread_start(&io, transport, backlog) < 0) {
+        return 1;
+    }
+    if (control_start(&control, &io) < 0) {
+        io_thread_stop(&io);
         return 1;
     }
-    printf("Scheduler server listening on %s...\n", SOCKET_PATH);
+    set_done_handler(send_done);
+    setup_signals();
+    printf("Scheduler server listening on %s...\n", transport == TRANSPORT_SHM ? SHM_PATH : SOCKET_PATH);
+    printf("Statistics and control on %s\n", CONTROL_SOCKET_PATH);
     uint32_t current_time_ms = 0;
-    while (1) {
-        check_new_commands(&command_queue, &blocked_queue, ready_ptr, server_fd, current_time_ms, scheduler_type);
-
-        if (current_time_ms%1000 == 0) {
-            printf("Current time: %d s\n", current_time_ms/1000);
+    uint32_t last_report_s = UINT32_MAX;
+    event_queue_t events = {0};
+    paced = !event_mode && speed > 0;
+    if (paced) {
+        pacer_start(&pacer, (uint64_t)(TICKS_MS * 1e6 / speed), pacer_mode);
+    }
+    while (!stop_requested) {
+        check_new_commands(&command_queue, &blocked_queue, &machine, current_time_ms,
+                           event_mode ? &events : NULL);
+
+        if (paused) {
+            // Requests are still taken and acknowledged, but the clock does not move
+            if (metrics_requested) {
+                metrics_requested = 0;
+                print_all_metrics(&machine, stdout);
+                fflush(stdout);
+            }
+            io_wait_event(&io, -1);
+            continue;
         }
-        check_blocked_queue(&blocked_queue, &command_queue, current_time_ms);
 
-        prev_CPU = CPU;
-
-        switch (scheduler_type) {
-            case SCHED_FIFO:
-                fifo_scheduler(current_time_ms, (queue_t *)ready_ptr, &CPU);
-                break;
-            case SCHED_SJF:
-                sjf_scheduler(current_time_ms, (queue_t *)ready_ptr, &CPU);
-                break;
-            case SCHED_MLFQ:
-                mlfq_scheduler(current_time_ms, (mlfq_ready_t *)ready_ptr, &CPU);
-                break;
-            default:
-                printf("Unknown scheduler type\n");
-                break;
+        if (current_time_ms/1000 != last_report_s) {
+            last_report_s = current_time_ms/1000;
+            printf("Current time: %d s\n", last_report_s);
+        }
+        check_blocked_queue(&blocked_queue, &command_queue, current_time_ms, &machine,
+                            event_mode ? &events : NULL);
+
+        machine_tick(&machine, current_time_ms);
+
+        for (uint32_t c = 0; c < machine.num_cpus; c++) {
+            pcb_t *prev_CPU = machine.cpus[c].prev;
+            pcb_t *CPU = machine.cpus[c].task;
+            metrics_cpu_switch(&metrics, prev_CPU, CPU, machine.cpus[c].preempted, current_time_ms);
+            trace_cpu_switch(prev_CPU, CPU, machine.cpus[c].preempted, c, current_time_ms,
+                             machine_ready_count(&machine), blocked_queue.count);
+
+            // Only tasks that finished their burst go back to the command queue (or on to their next submitted
+            // burst), preempted ones are already re-queued
+            if (prev_CPU && prev_CPU != CPU && prev_CPU->status == TASK_STOPPED) {
+                prev_CPU->ellapsed_time_ms = 0;
+                if (prev_CPU->workload) {
+                    advance_workload(prev_CPU, 0, &command_queue, &blocked_queue, &machine,
+                                     event_mode ? &events : NULL, current_time_ms);
+                } else {
+                    enqueue_command(&command_queue, prev_CPU);
+                }
+            }
         }
 
-        if (prev_CPU && !CPU) {
-            prev_CPU->status = TASK_COMMAND;
-            prev_CPU->ellapsed_time_ms = 0;
-            enqueue_pcb(&command_queue, prev_CPU);
+        if (metrics_requested) {
+            metrics_requested = 0;
+            print_all_metrics(&machine, stdout);
+            fflush(stdout);
         }
 
-        usleep(TICKS_MS * 1000);
-        current_time_ms += TICKS_MS;
+        if (event_mode) {
+            current_time_ms = advance_to_next_event(&events, &machine, &command_queue, current_time_ms);
+        } else if (paced) {
+            pacer_wait(&pacer, &stop_requested);
+            current_time_ms += TICKS_MS;
+        } else {
+            keep_up_with_clients(&command_queue, &blocked_queue, &machine, current_time_ms);
+            current_time_ms += TICKS_MS;
+        }
     }
 
+    printf("Scheduler stopped at time %u ms\n", current_time_ms);
+    control_stop(&control);
+    print_all_metrics(&machine, stdout);
+    free_metrics(&metrics);
+    trace_close();
+    free_event_queue(&events);
+    machine_destroy(&machine);
+    io_thread_stop(&io);
+    print_latency(stdout);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "control.h"
+#include "msg.h"
+
+/**
+ * @brief Sends one command line to the control socket and copies the answer to stdout.
+ * @return 0 on success, -1 if the simulator cannot be reached or refused the command.
+ */
+static int send_command(const char *line) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, CONTROL_SOCKET_PATH, sizeof(addr.sun_path) - 1);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("connect " CONTROL_SOCKET_PATH);
+        close(fd);
+        return -1;
+    }
+    size_t len = strlen(line);
+    if (write(fd, line, len) != (ssize_t)len) {
+        perror("write");
+        close(fd);
+        return -1;
+    }
+    shutdown(fd, SHUT_WR);
+
+    char buf[4096];
+    ssize_t n;
+    int status = 0, first = 1;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        if (first && n >= 6 && memcmp(buf, "Error:", 6) == 0) status = -1;
+        first = 0;
+        fwrite(buf, 1, (size_t)n, stdout);
+    }
+    if (n < 0) {
+        perror("read");
+        status = -1;
+    }
+    fflush(stdout);
+    close(fd);
+    return status;
+}
+
+/**
+ * @brief Talks to the control socket of a running ossim, see control.h.
+ *
+ * With -i the command is repeated every interval until interrupted, to watch a long run.
+ */
+int main(int argc, char *argv[]) {
+    unsigned interval_s = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:")) != -1) {
+        if (opt == 'i') {
+            char *endptr;
+            long value = strtol(optarg, &endptr, 10);
+            if (*endptr != '\0' || value <= 0 || value > 86400) {
+                fprintf(stderr, "Invalid interval: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+            interval_s = (unsigned)value;
+        } else {
+            optind = argc + 1;
+            break;
+        }
+    }
+    if (optind >= argc) {
+        printf("Usage: %s [-i SECONDS] <command> [arguments]\n", argv[0]);
+        printf("Commands: stats, metrics, pause, resume, quantum [LEVEL] MS, help\n");
+        return EXIT_FAILURE;
+    }
+
+    char line[CONTROL_LINE_MAX];
+    size_t len = 0;
+    for (int i = optind; i < argc; i++) {
+        int n = snprintf(line + len, sizeof(line) - len, "%s%s", i > optind ? " " : "", argv[i]);
+        if (n < 0 || (size_t)n >= sizeof(line) - len - 1) {
+            fprintf(stderr, "Command too long\n");
+            return EXIT_FAILURE;
+        }
+        len += (size_t)n;
+    }
+    line[len++] = '\n';
+    line[len] = '\0';
+
+    int status = send_command(line);
+    while (interval_s > 0 && status == 0) {
+        sleep(interval_s);
+        printf("\n");
+        status = send_command(line);
+    }
+    return status == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,80 @@
+#include "pacer.h"
+
+#include <errno.h>
+#include <time.h>
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Sleeps until the absolute time deadline_ns.
+ * @return 0 once the deadline is reached, -1 if a signal came first and *stop is set.
+ */
+static int sleep_until(uint64_t deadline_ns, const volatile sig_atomic_t *stop) {
+    struct timespec ts = {
+        .tv_sec = (time_t)(deadline_ns / 1000000000ull),
+        .tv_nsec = (long)(deadline_ns % 1000000000ull),
+    };
+    int err;
+    while ((err = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)) == EINTR) {
+        if (stop && *stop) return -1;
+    }
+    return 0;
+}
+
+void pacer_start(pacer_t *pacer, uint64_t period_ns, pacer_mode_en mode) {
+    *pacer = (pacer_t){ .mode = mode, .period_ns = period_ns > 0 ? period_ns : 1 };
+    pacer->deadline_ns = now_ns() + pacer->period_ns;
+}
+
+void pacer_restart(pacer_t *pacer) {
+    pacer->deadline_ns = now_ns() + pacer->period_ns;
+}
+
+int pacer_wait(pacer_t *pacer, const volatile sig_atomic_t *stop) {
+    uint64_t deadline = pacer->deadline_ns;
+    uint64_t now = now_ns();
+    int late = 0;
+
+    pacer->ticks++;
+    if (now < deadline) {
+        if (pacer->mode == PACER_SPIN) {
+            if (deadline - now > PACER_SPIN_NS && sleep_until(deadline - PACER_SPIN_NS, stop) < 0) return 0;
+            while (now_ns() < deadline) {
+                if (stop && *stop) return 0;
+            }
+        } else if (sleep_until(deadline, stop) < 0) {
+            return 0;
+        }
+    } else {
+        late = now > deadline;
+        if (late) {
+            pacer->late++;
+            if (now - deadline > pacer->max_late_ns) pacer->max_late_ns = now - deadline;
+        }
+        if (now - deadline > PACER_RESYNC_NS) {
+            // Catching up would run the ticks back to back for too long: start afresh from now
+            pacer->resyncs++;
+            pacer->dropped_ns += now - deadline;
+            fprintf(stderr, "Ticks fell %.0f ms behind real time, skipping ahead\n", (double)(now - deadline) / 1e6);
+            deadline = now;
+        }
+    }
+    pacer->deadline_ns = deadline + pacer->period_ns;
+    return late;
+}
+
+void print_pacer_stats(const pacer_t *pacer, FILE *out) {
+    fprintf(out, "Pacing: %llu ticks of %.3f ms, %llu late (%.1f%%, up to %.3f ms behind)",
+            (unsigned long long)pacer->ticks, (double)pacer->period_ns / 1e6, (unsigned long long)pacer->late,
+            pacer->ticks ? 100.0 * (double)pacer->late / (double)pacer->ticks : 0.0,
+            (double)pacer->max_late_ns / 1e6);
+    if (pacer->resyncs > 0) {
+        fprintf(out, ", %llu times more than %d ms behind (%.3f s skipped)",
+                (unsigned long long)pacer->resyncs, PACER_RESYNC_NS / 1000000, (double)pacer->dropped_ns / 1e9);
+    }
+    fprintf(out, "\n");
+}
@@ -0,0 +1,60 @@
+#ifndef PACER_H
+#define PACER_H
+
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define PACER_SPIN_NS 200000        // Last part of each tick spent spinning in PACER_SPIN mode
+#define PACER_RESYNC_NS 1000000000  // How far behind the pacer may fall before giving up on catching up
+
+/*
+ * Paces the ticks of the simulator on absolute CLOCK_MONOTONIC deadlines: tick n ends at
+ * start + n * period whatever the time spent processing it, so the simulated clock does not drift
+ * from real time on a busy host. A tick that ends past its deadline is counted as late and the
+ * next one starts at once, catching up. Only when the pacer falls more than PACER_RESYNC_NS
+ * behind (the process was stopped, the host is overloaded) does it give up and start afresh
+ * from the current time.
+ */
+typedef enum {
+    PACER_SLEEP = 0,                // clock_nanosleep to the deadline
+    PACER_SPIN,                     // Sleep, then spin the last PACER_SPIN_NS: sub-millisecond ticks stay on time
+} pacer_mode_en;
+
+typedef struct {
+    pacer_mode_en mode;
+    uint64_t period_ns;             // Real duration of a tick
+    uint64_t deadline_ns;           // End of the current tick
+    uint64_t ticks;
+    uint64_t late;                  // Ticks that ended past their deadline
+    uint64_t max_late_ns;
+    uint64_t resyncs;               // Times the pacer gave up catching up
+    uint64_t dropped_ns;            // Real time given up that way
+} pacer_t;
+
+/**
+ * @brief Starts pacing ticks of period_ns, the first one ending period_ns from now.
+ */
+void pacer_start(pacer_t *pacer, uint64_t period_ns, pacer_mode_en mode);
+
+/**
+ * @brief Starts the next tick period_ns from now, keeping the statistics.
+ *
+ * For a clock that was stopped on purpose: the time it stood still is neither late nor caught up.
+ */
+void pacer_restart(pacer_t *pacer);
+
+/**
+ * @brief Waits for the end of the current tick.
+ *
+ * Signals interrupt the wait only when *stop is set, so that a SIGUSR1 does not shorten a tick.
+ * @return 1 if the tick was late, 0 otherwise.
+ */
+int pacer_wait(pacer_t *pacer, const volatile sig_atomic_t *stop);
+
+/**
+ * @brief Prints how many ticks were late and by how much.
+ */
+void print_pacer_stats(const pacer_t *pacer, FILE *out);
+
+#endif //PACER_H
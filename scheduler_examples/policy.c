@@ -0,0 +1,114 @@
+#include "policy.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fifo.h"
+#include "mlfq.h"
+#include "msg.h"
+#include "RR.h"
+#include "sjf.h"
+
+// Registry of the available policies, in the order they are listed to the user
+const scheduler_policy_t *const SCHEDULER_POLICIES[] = {
+    &fifo_policy,
+    &sjf_policy,
+    &rr_policy,
+    &mlfq_policy,
+    NULL
+};
+
+const scheduler_policy_t *find_policy(const char *name) {
+    for (int i = 0; SCHEDULER_POLICIES[i] != NULL; i++) {
+        if (strcmp(name, SCHEDULER_POLICIES[i]->name) == 0) {
+            return SCHEDULER_POLICIES[i];
+        }
+    }
+    return NULL;
+}
+
+// Replaces the DONE message when there is no application on the other side (batch mode), or
+// when the simulator reaches its applications through another transport than the socket.
+// Per thread, so that parallel batch simulations do not see each other's handler.
+static _Thread_local done_handler_t done_handler = NULL;
+
+void set_done_handler(done_handler_t handler) {
+    done_handler = handler;
+}
+
+void finish_burst(pcb_t *task, uint32_t current_time_ms) {
+    if (done_handler) {
+        done_handler(task, current_time_ms);
+    } else if (!task->workload) {
+        // Tasks with submitted bursts are only told when the last of them is over
+        msg_t msg = {
+            .pid = task->pid,
+            .request = PROCESS_REQUEST_DONE,
+            .time_ms = current_time_ms
+        };
+        if (write(task->sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
+            perror("write");
+        }
+    }
+    // Do not free here; main loop will re-enqueue to command_queue
+    task->status = TASK_STOPPED;
+}
+
+void preempt_burst(pcb_t *task) {
+    task->preempted = 1;
+}
+
+int quantum_expired(const pcb_t *task, uint32_t quantum_ms, uint32_t current_time_ms) {
+    // Approximate including current tick
+    uint32_t slice_elapsed_ms = current_time_ms - task->slice_start_ms + TICKS_MS;
+    return slice_elapsed_ms >= quantum_ms;
+}
+
+int parse_uint_list(const char *list, uint32_t *values, int max_values) {
+    int count = 0;
+    const char *p = list;
+    while (*p) {
+        char *endptr;
+        unsigned long value = strtoul(p, &endptr, 10);
+        if (endptr == p || *p == '-' || value == 0 || value > UINT32_MAX || count == max_values) return -1;
+        values[count++] = (uint32_t)value;
+        if (*endptr == ',') endptr++;
+        else if (*endptr != '\0') return -1;
+        p = endptr;
+    }
+    return count;
+}
+
+/**
+ * @brief Computes when the running task next changes state.
+ *
+ * Mirrors the per-tick accounting of the policies: the burst completes on the first tick
+ * where ellapsed_time_ms reaches time_ms, and a preemptive policy preempts on the first tick
+ * where the slice (including that tick) reaches the task's quantum.
+ *
+ * @return Simulation time of the next CPU event, or UINT32_MAX if the CPU is idle.
+ */
+uint32_t next_cpu_event_ms(const scheduler_policy_t *policy, const void *ready_queue, const pcb_t *cpu,
+                           uint32_t current_time_ms, event_type_en *type) {
+    if (!cpu) return UINT32_MAX;
+
+    uint32_t remaining_ms = cpu->time_ms > cpu->ellapsed_time_ms ? cpu->time_ms - cpu->ellapsed_time_ms : 0;
+    uint32_t ticks = (remaining_ms + TICKS_MS - 1) / TICKS_MS;
+    uint32_t event_ms = current_time_ms + (ticks > 0 ? ticks : 1) * TICKS_MS;
+    *type = EVENT_BURST_DONE;
+
+    uint32_t quantum_ms = policy->quantum_ms(ready_queue, cpu);
+    if (quantum_ms != UINT32_MAX) {
+        // The current tick counts toward the slice, see quantum_expired()
+        uint32_t slice_ticks = quantum_ms > TICKS_MS ? (quantum_ms - 1) / TICKS_MS : 0;
+        uint32_t expiry_ms = cpu->slice_start_ms + slice_ticks * TICKS_MS;
+        if (expiry_ms <= current_time_ms) expiry_ms = current_time_ms + TICKS_MS;
+        if (expiry_ms < event_ms) {
+            event_ms = expiry_ms;
+            *type = EVENT_QUANTUM_EXPIRED;
+        }
+    }
+    return event_ms;
+}
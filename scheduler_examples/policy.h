@@ -0,0 +1,77 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include <stdint.h>
+#include "event_queue.h"
+#include "queue.h"
+
+// Settings a policy may read when it creates its ready-queue state
+typedef struct {
+    uint32_t rr_quantum_ms;             // Round-Robin time slice
+    uint32_t mlfq_levels;               // Number of MLFQ levels
+    const uint32_t *mlfq_quanta;        // Time slice of each MLFQ level, level 0 first
+} policy_config_t;
+
+/*
+ * Interface every scheduling policy implements. The main loop only talks to a policy
+ * through these functions and the opaque state returned by init, so adding a policy
+ * means adding an entry to the registry in policy.c.
+ *
+ * On every tick the loop calls tick(), which accounts the tick to the running task and
+ * either finishes it (finish_burst(): sends DONE, sets TASK_STOPPED, then clears *cpu_task) or
+ * preempts it (preempt_burst(), then back into the ready queue). If the CPU is then idle, pick() selects the next task.
+ */
+typedef struct {
+    const char *name;
+    void *(*init)(const policy_config_t *config);
+    int (*enqueue)(void *rq, pcb_t *task);                                  // Task requested RUN
+    void (*tick)(void *rq, uint32_t current_time_ms, pcb_t **cpu_task);
+    pcb_t *(*pick)(void *rq, uint32_t current_time_ms);
+    uint32_t (*ready_count)(const void *rq);
+    uint32_t (*quantum_ms)(const void *rq, const pcb_t *task);              // UINT32_MAX if never preempted
+    void (*destroy)(void *rq);
+    // Optional, NULL for a policy with a single level or without a quantum
+    uint32_t (*level_counts)(const void *rq, uint32_t *ready);              // Ready tasks per level, returns the levels
+    int (*set_quantum)(void *rq, uint32_t level, uint32_t quantum_ms);      // -1 if there is no such level
+
+} scheduler_policy_t;
+
+extern const scheduler_policy_t *const SCHEDULER_POLICIES[];
+
+const scheduler_policy_t *find_policy(const char *name);
+
+typedef void (*done_handler_t)(pcb_t *task, uint32_t current_time_ms);
+
+/**
+ * @brief Sends DONE to the application of a task whose CPU burst has completed.
+ */
+void finish_burst(pcb_t *task, uint32_t current_time_ms);
+
+/**
+ * @brief Marks a running task whose quantum expired, before the policy puts it back in its ready queue.
+ *
+ * machine_tick() reports it in cpu_t.preempted even when the same task gets the CPU back at once.
+ */
+void preempt_burst(pcb_t *task);
+
+/**
+ * @brief Routes completed bursts to a handler instead of the task's socket, NULL restores the socket.
+ */
+void set_done_handler(done_handler_t handler);
+
+/**
+ * @brief Tells whether a task running since slice_start_ms has used up its quantum at this tick.
+ */
+int quantum_expired(const pcb_t *task, uint32_t quantum_ms, uint32_t current_time_ms);
+
+/**
+ * @brief Parses a comma-separated list of positive integers, e.g. the values of a command-line option.
+ *
+ * @return Number of values read, or -1 if the list is invalid or has more than max_values.
+ */
+int parse_uint_list(const char *list, uint32_t *values, int max_values);
+
+uint32_t next_cpu_event_ms(const scheduler_policy_t *policy, const void *ready_queue, const pcb_t *cpu,
+                           uint32_t current_time_ms, event_type_en *type);
+
+#endif //POLICY_H
@@ -10,19 +10,63 @@ pcb_t *new_pcb(pid_t pid, uint32_t sockfd, uint32_t time_ms) {
     new_task->pid = pid;
     new_task->status = TASK_COMMAND;
     new_task->slice_start_ms = 0;
+    new_task->wake_time_ms = 0;
     new_task->sockfd = sockfd;
     new_task->time_ms = time_ms;
     new_task->ellapsed_time_ms = 0;
     new_task->level = 0;
+    new_task->preempted = 0;
+    new_task->partial = NULL;
+    new_task->cpu = UINT32_MAX;    // Placed by machine_enqueue()
+    new_task->elem = NULL;
+    new_task->stats = (pcb_stats_t){0};
+    new_task->workload = NULL;
+    new_task->workload_len = 0;
+    new_task->workload_pos = 0;
     return new_task;
 }
 
+/*
+ * Queue elements are recycled through a free list instead of going back to the allocator.
+ * When the list runs dry a whole slab of QUEUE_ELEM_SLAB elements is allocated at once, so in
+ * steady state (a bounded number of tasks moving between queues) enqueue and dequeue never
+ * call malloc or free. Slabs are kept for the lifetime of the process. The free list is per
+ * thread, so batch simulations running in parallel never share elements.
+ */
+#define QUEUE_ELEM_SLAB 256
+
+static _Thread_local queue_elem_t *free_elems = NULL;
+
+static queue_elem_t *alloc_queue_elem(void) {
+    if (!free_elems) {
+        queue_elem_t *slab = malloc(QUEUE_ELEM_SLAB * sizeof(queue_elem_t));
+        if (!slab) return NULL;
+        for (int i = 0; i < QUEUE_ELEM_SLAB - 1; i++) {
+            slab[i].next = &slab[i + 1];
+        }
+        slab[QUEUE_ELEM_SLAB - 1].next = NULL;
+        free_elems = slab;
+    }
+    queue_elem_t *elem = free_elems;
+    free_elems = elem->next;
+    return elem;
+}
+
+void free_queue_elem(queue_elem_t *elem) {
+    if (!elem) return;
+    elem->pcb = NULL;
+    elem->next = free_elems;
+    free_elems = elem;
+}
+
 int enqueue_pcb(queue_t* q, pcb_t* task) {
-    queue_elem_t* elem = malloc(sizeof(queue_elem_t));
+    queue_elem_t* elem = alloc_queue_elem();
     if (!elem) return 0;
 
     elem->pcb = task;
     elem->next = NULL;
+    elem->prev = q->tail;
+    task->elem = elem;
 
     if (q->tail) {
         q->tail->next = elem;
@@ -30,6 +74,7 @@ int enqueue_pcb(queue_t* q, pcb_t* task) {
         q->head = elem;
     }
     q->tail = elem;
+    q->count++;
     return 1;
 }
 
@@ -40,31 +85,50 @@ pcb_t* dequeue_pcb(queue_t* q) {
     pcb_t* task = node->pcb;
 
     q->head = node->next;
-    if (!q->head)
+    if (q->head)
+        q->head->prev = NULL;
+    else
         q->tail = NULL;
 
-    free(node);
+    q->count--;
+    task->elem = NULL;
+    free_queue_elem(node);
     return task;
 }
 
+/**
+ * @brief Unlinks an element from the queue in constant time.
+ *
+ * The element must belong to q. Its next pointer is left untouched so that callers
+ * iterating over the queue can still advance after removing the current element.
+ *
+ * @return The unlinked element, to be released with free_queue_elem().
+ */
 queue_elem_t *remove_queue_elem(queue_t* q, queue_elem_t* elem) {
-    queue_elem_t* it = q->head;
-    queue_elem_t* prev = NULL;
-    while (it != NULL) {
-        if (it == elem) {
-            if (prev) {
-                prev->next = it->next;
-            } else {
-                q->head = it->next;
-            }
-            if (it == q->tail) {
-                q->tail = prev;
-            }
-            return it;
-        }
-        prev = it;
-        it = it->next;
+    if (!elem) return NULL;
+
+    if (elem->prev) {
+        elem->prev->next = elem->next;
+    } else {
+        q->head = elem->next;
+    }
+    if (elem->next) {
+        elem->next->prev = elem->prev;
+    } else {
+        q->tail = elem->prev;
+    }
+    q->count--;
+    if (elem->pcb && elem->pcb->elem == elem) elem->pcb->elem = NULL;
+    return elem;
+}
+
+/**
+ * @brief Unlinks a task from the queue it is in, using the task's back-pointer to its element.
+ */
+queue_elem_t *remove_queue_pcb(queue_t* q, pcb_t* task) {
+    if (!task->elem) {
+        printf("Task %d is not in a queue\n", task->pid);
+        return NULL;
     }
-    printf("Queue element not found in queue\n");
-    return NULL;
+    return remove_queue_elem(q, task->elem);
 }
\ No newline at end of file
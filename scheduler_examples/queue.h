@@ -10,6 +10,23 @@ typedef enum  {
     TASK_TERMINATED,    // Task has been terminated and will be removed
 } task_status_en;
 
+// Timestamps and counters of a task, maintained by metrics.c
+typedef struct {
+    uint32_t arrival_ms;           // First RUN request of the task
+    uint32_t response_ms;          // Time from the first RUN request to the first dispatch
+    uint32_t last_done_ms;         // Completion of the last CPU burst
+    uint32_t wait_ms;              // Total time spent in the ready queue
+    uint32_t preemptions;          // Total times the task lost the CPU before finishing a burst
+    uint32_t bursts;               // Number of CPU bursts requested so far
+    uint32_t burst_arrival_ms;     // RUN request of the current burst
+    uint32_t burst_first_run_ms;   // First dispatch of the current burst, UINT32_MAX until then
+    uint32_t burst_wait_ms;        // Time the current burst spent in the ready queue
+    uint32_t burst_preemptions;    // Preemptions of the current burst
+    uint32_t ready_since_ms;       // Last time the task entered the ready queue
+    uint32_t dispatch_ms;          // Last time the task got the CPU
+    uint32_t open_index;           // Position in metrics_t.open while the task is connected
+} pcb_stats_t;
+
 // Define the Process Control Block (PCB) structure
 typedef struct pcb_st{
     int32_t pid;                   // Process ID
@@ -17,26 +34,39 @@ typedef struct pcb_st{
     uint32_t time_ms;              // Time requested by application in milliseconds
     uint32_t ellapsed_time_ms;     // Time ellapsed since start in milliseconds
     uint32_t slice_start_ms;       // Time when the current time slice started
-    uint32_t sockfd;               // Socket file descriptor for communication with the application
+    uint32_t wake_time_ms;         // Time when a blocked task finishes its I/O wait
+    uint32_t sockfd;               // Socket file descriptor (or shared-memory slot) of the application
     uint8_t level;                 // Current MLFQ level (0 = highest priority)
+    uint8_t preempted;             // Lost the CPU at this tick before the end of its burst, see preempt_burst()
+    uint32_t cpu;                  // CPU whose ready queue holds the task, or that runs or last ran it
+    struct queue_elem_st *elem;    // Element holding the task while it is in a queue, NULL otherwise
+    pcb_stats_t stats;             // Scheduler-side metrics of the task
+    struct burst_msg_st *workload; // Bursts submitted with SUBMIT, NULL when driven by RUN/BLOCK
+    uint32_t workload_len;         // Number of submitted bursts
+    uint32_t workload_pos;         // Submitted burst the task is running or blocked after
+    struct io_partial_st *partial; // Request the I/O thread has only partly read, see io_thread.c
 } pcb_t;
 
-// Define singly linked list elements
+// Define doubly linked list elements
 typedef struct queue_elem_st queue_elem_t;
 typedef struct queue_elem_st {
     pcb_t *pcb;
     queue_elem_t *next;
+    queue_elem_t *prev;
 } queue_elem_t;
 
 // Define the queue structure
 typedef struct queue_st  {
     queue_elem_t* head;
     queue_elem_t* tail;
+    uint32_t count;                // Number of elements in the queue
 } queue_t;
 
 pcb_t *new_pcb(int32_t pid, uint32_t sockfd, uint32_t time_ms);
 int enqueue_pcb(queue_t* q, pcb_t* task);
 pcb_t* dequeue_pcb(queue_t* q);
 queue_elem_t *remove_queue_elem(queue_t* q, queue_elem_t* elem);
+queue_elem_t *remove_queue_pcb(queue_t* q, pcb_t* task);
+void free_queue_elem(queue_elem_t *elem);
 
 #endif //QUEUE_H
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "scenario.h"
+
+#include <ctype.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LINE_LEN 1024
+
+static char *get_basename_no_ext(const char *path) {
+    const char *slash = strrchr(path, '/');
+    const char *base = slash ? slash + 1 : path;
+
+    const char *dot = strrchr(base, '.');
+    size_t len = dot ? (size_t)(dot - base) : strlen(base);
+    char *result = malloc(len + 1);
+    if (!result) return NULL;
+    memcpy(result, base, len);
+    result[len] = '\0';
+    return result;
+}
+
+/**
+ * @brief Streams the times of the bursts of a burst file into an array.
+ * @return The number of bursts, or -1 on error.
+ */
+static int read_burst_times(const char *path, burst_msg_t **bursts) {
+    burst_reader_t reader;
+    *bursts = NULL;
+    if (burst_reader_open(&reader, path) < 0) return -1;
+    if (reader.max_bursts == 0) return 0;
+    if (reader.max_bursts > INT_MAX) {
+        fprintf(stderr, "%s: too many bursts\n", path);
+        burst_reader_close(&reader);
+        return -1;
+    }
+
+    burst_msg_t *array = malloc(reader.max_bursts * sizeof(burst_msg_t));
+    if (!array) {
+        burst_reader_close(&reader);
+        return -1;
+    }
+    uint64_t count = 0;
+    int status = 0;
+    burst_t burst;
+    while (count < reader.max_bursts && (status = burst_reader_next(&reader, &burst)) > 0) {
+        array[count].burst_time_ms = burst.burst_time_ms;
+        array[count].block_time_ms = burst.block_time_ms;
+        count++;
+    }
+    burst_reader_close(&reader);
+
+    if (status < 0 || count == 0) {
+        free(array);
+        return status;
+    }
+    burst_msg_t *shrunk = realloc(array, count * sizeof(burst_msg_t));
+    *bursts = shrunk ? shrunk : array;
+    return (int)count;
+}
+
+static int load_workload(batch_scenario_t *s, const char *path) {
+    for (uint32_t i = 0; i < s->num_workloads; i++) {
+        if (strcmp(s->workloads[i].path, path) == 0) return (int)i;
+    }
+
+    burst_msg_t *bursts;
+    int count = read_burst_times(path, &bursts);
+    if (count <= 0) {
+        fprintf(stderr, "Failed to read burst file %s\n", path);
+        return -1;
+    }
+
+    batch_workload_t *tmp = realloc(s->workloads, (s->num_workloads + 1) * sizeof(batch_workload_t));
+    if (!tmp) {
+        free(bursts);
+        return -1;
+    }
+    s->workloads = tmp;
+
+    batch_workload_t *w = &s->workloads[s->num_workloads++];
+    w->path = strdup(path);
+    w->name = get_basename_no_ext(path);
+    w->bursts = bursts;
+    w->count = (uint32_t)count;
+    if (!w->path || !w->name) return -1;
+    return (int)(s->num_workloads - 1);
+}
+
+static int add_apps(batch_scenario_t *s, uint32_t workload, uint32_t arrival_ms, uint32_t copies) {
+    batch_app_t *tmp = realloc(s->apps, ((size_t)s->num_apps + copies) * sizeof(batch_app_t));
+    if (!tmp) return -1;
+    s->apps = tmp;
+
+    for (uint32_t i = 0; i < copies; i++) {
+        s->apps[s->num_apps++] = (batch_app_t){ .workload = workload, .arrival_ms = arrival_ms };
+    }
+    return 0;
+}
+
+batch_scenario_t *load_scenario(const char *scenario_file) {
+    FILE *file = fopen(scenario_file, "r");
+    if (!file) {
+        perror("fopen");
+        return NULL;
+    }
+    batch_scenario_t *s = calloc(1, sizeof(batch_scenario_t));
+    if (!s) {
+        fclose(file);
+        return NULL;
+    }
+
+    // Burst files are relative to the scenario file
+    const char *slash = strrchr(scenario_file, '/');
+    size_t dir_len = slash ? (size_t)(slash - scenario_file + 1) : 0;
+
+    char line[MAX_LINE_LEN];
+    char path[MAX_LINE_LEN * 2];
+    int line_no = 0;
+    int ret = 0;
+    while (ret == 0 && fgets(line, sizeof(line), file)) {
+        line_no++;
+        char *trimmed = line;
+        while (isspace((unsigned char)*trimmed)) ++trimmed;
+        if (*trimmed == '#' || *trimmed == '\0') continue;
+        trimmed[strcspn(trimmed, "\r\n")] = '\0';
+
+        char *endptr;
+        unsigned long arrival_ms = strtoul(trimmed, &endptr, 10);
+        if (endptr == trimmed || *endptr != ',' || arrival_ms > UINT32_MAX) {
+            fprintf(stderr, "%s:%d: expected <arrival_ms>,<burst-file>[,<copies>]\n", scenario_file, line_no);
+            ret = -1;
+            break;
+        }
+        char *name = endptr + 1;
+        unsigned long copies = 1;
+        char *comma = strchr(name, ',');
+        if (comma) {
+            *comma = '\0';
+            copies = strtoul(comma + 1, &endptr, 10);
+            if (endptr == comma + 1 || *endptr != '\0' || copies == 0 || copies > INT32_MAX) {
+                fprintf(stderr, "%s:%d: invalid number of copies\n", scenario_file, line_no);
+                ret = -1;
+                break;
+            }
+        }
+
+        if (name[0] == '/') {
+            snprintf(path, sizeof(path), "%s", name);
+        } else {
+            snprintf(path, sizeof(path), "%.*s%s", (int)dir_len, scenario_file, name);
+        }
+        int workload = load_workload(s, path);
+        if (workload < 0 || add_apps(s, (uint32_t)workload, (uint32_t)arrival_ms, (uint32_t)copies) < 0) {
+            fprintf(stderr, "%s:%d: failed to load %s\n", scenario_file, line_no, path);
+            ret = -1;
+        }
+    }
+    fclose(file);
+    if (ret == 0 && s->num_apps == 0) {
+        fprintf(stderr, "Scenario %s has no applications\n", scenario_file);
+        ret = -1;
+    }
+    if (ret < 0) {
+        free_scenario(s);
+        return NULL;
+    }
+    return s;
+}
+
+void free_scenario(batch_scenario_t *s) {
+    if (!s) return;
+    for (uint32_t i = 0; i < s->num_workloads; i++) {
+        free(s->workloads[i].path);
+        free(s->workloads[i].name);
+        free(s->workloads[i].bursts);
+    }
+    free(s->workloads);
+    free(s->apps);
+    free(s);
+}
+
+uint32_t scenario_app_count(const batch_scenario_t *s) {
+    return s->num_apps;
+}
@@ -0,0 +1,46 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <stdint.h>
+#include "burst_queue.h"
+
+// Bursts of one burst file, loaded once and shared by every application using it
+typedef struct {
+    char *path;
+    char *name;                     // Basename without extension, used as application name
+    burst_msg_t *bursts;            // Times only: pages and nice values are not simulated
+    uint32_t count;
+} batch_workload_t;
+
+// One application of the scenario
+typedef struct {
+    uint32_t workload;              // Index into the scenario's workloads
+    uint32_t arrival_ms;
+} batch_app_t;
+
+// Applications of a scenario file, with their burst files loaded (read-only once loaded)
+typedef struct batch_scenario_st {
+    batch_workload_t *workloads;
+    uint32_t num_workloads;
+    batch_app_t *apps;
+    uint32_t num_apps;
+} batch_scenario_t;
+
+/**
+ * @brief Reads a scenario file and the burst files it refers to.
+ *
+ * The scenario file lists one application per line as
+ *     <arrival_ms>,<burst-file.csv>[,<copies>]
+ * where the burst file uses a format of app-io, text or binary, and relative paths are resolved against
+ * the directory of the scenario file. Lines starting with '#' are comments.
+ *
+ * @param scenario_file Path to the scenario file.
+ * @return The scenario, or NULL on error.
+ */
+batch_scenario_t *load_scenario(const char *scenario_file);
+
+void free_scenario(batch_scenario_t *scenario);
+
+uint32_t scenario_app_count(const batch_scenario_t *scenario);
+
+#endif //SCENARIO_H
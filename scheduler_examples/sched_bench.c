@@ -0,0 +1,414 @@
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fifo.h"
+#include "msg.h"
+#include "mlfq.h"
+#include "policy.h"
+#include "queue.h"
+#include "RR.h"
+#include "sjf.h"
+
+#define MAX_BENCH_SIZES 32
+#define MAX_BURST_TICKS 8                   // Bursts last 1 to MAX_BURST_TICKS ticks
+#define DEFAULT_ITERATIONS 1000000
+
+/*
+ * Microbenchmark of the scheduling kernels with synthetic ready queues.
+ *
+ * Each policy is driven through the same enqueue/tick/pick calls as one CPU of ossim, with every
+ * task of the queue always ready: the done handler stands in for the sockets and sends a task
+ * that finished its burst straight back to the ready queue with a new random burst, so the queue
+ * length stays constant. The named entry points (fifo_scheduler() and the others), which run a whole
+ * tick on ready state the caller owns, are timed the same way after the policy they belong to. The
+ * queue primitives are measured on their own with the same lengths.
+ *
+ * Allocations are counted by wrapping malloc, calloc and realloc at link time (-Wl,--wrap).
+ */
+
+static uint64_t allocations;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    allocations++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    allocations++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    allocations++;
+    return __real_realloc(ptr, size);
+}
+
+typedef struct {
+    const char *kernel;
+    uint32_t queue_len;
+    uint64_t iterations;
+    uint64_t elapsed_ns;
+    uint64_t dispatches;                    // Policies only
+    uint64_t allocations;
+} bench_result_t;
+
+static uint64_t rng_state = 88172645463325252ull;
+
+static uint32_t next_random(void) {
+    rng_state ^= rng_state << 13;           // xorshift64, the same sequence on every run
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)(rng_state >> 32);
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void new_burst(pcb_t *task) {
+    task->time_ms = (1 + next_random() % MAX_BURST_TICKS) * TICKS_MS;
+    task->ellapsed_time_ms = 0;
+    task->status = TASK_RUNNING;
+}
+
+static pcb_t **new_tasks(uint32_t count) {
+    pcb_t **tasks = malloc(count * sizeof(pcb_t *));
+    if (!tasks) return NULL;
+    for (uint32_t i = 0; i < count; i++) {
+        tasks[i] = new_pcb((int32_t)i + 1, 0, 0);
+        if (!tasks[i]) {
+            while (i > 0) free(tasks[--i]);
+            free(tasks);
+            return NULL;
+        }
+        new_burst(tasks[i]);
+    }
+    return tasks;
+}
+
+static void free_tasks(pcb_t **tasks, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) free(tasks[i]);
+    free(tasks);
+}
+
+static pcb_t *finished_task;                // Set by the done handler during tick()
+
+static void bench_done(pcb_t *task, uint32_t current_time_ms) {
+    (void)current_time_ms;
+    task->status = TASK_STOPPED;
+    finished_task = task;
+}
+
+static int bench_policy(const scheduler_policy_t *policy, const policy_config_t *config,
+                        uint32_t queue_len, uint64_t iterations, bench_result_t *result) {
+    pcb_t **tasks = new_tasks(queue_len);
+    void *rq = policy->init(config);
+    if (!tasks || !rq) {
+        fprintf(stderr, "Out of memory for %u tasks\n", queue_len);
+        if (tasks) free_tasks(tasks, queue_len);
+        if (rq) policy->destroy(rq);
+        return -1;
+    }
+    for (uint32_t i = 0; i < queue_len; i++) policy->enqueue(rq, tasks[i]);
+
+    pcb_t *cpu = NULL;
+    uint64_t dispatches = 0;
+    uint64_t allocations_before = allocations;
+    uint64_t start = now_ns();
+    for (uint64_t tick = 0; tick < iterations; tick++) {
+        uint32_t current_time_ms = (uint32_t)(tick * TICKS_MS);
+        finished_task = NULL;
+        policy->tick(rq, current_time_ms, &cpu);
+        if (!cpu) {
+            cpu = policy->pick(rq, current_time_ms);
+            if (cpu) dispatches++;
+        }
+        if (finished_task) {
+            new_burst(finished_task);
+            policy->enqueue(rq, finished_task);
+        }
+    }
+    uint64_t elapsed = now_ns() - start;
+    *result = (bench_result_t){
+        .kernel = policy->name,
+        .queue_len = queue_len,
+        .iterations = iterations,
+        .elapsed_ns = elapsed,
+        .dispatches = dispatches,
+        .allocations = allocations - allocations_before,
+    };
+
+    // Give the queue elements back to the free list before the tasks go away
+    while (policy->pick(rq, 0) != NULL) {}
+    policy->destroy(rq);
+    free_tasks(tasks, queue_len);
+    return 0;
+}
+
+// Named entry point of a policy, with the ready state it takes
+typedef struct {
+    const scheduler_policy_t *policy;
+    const char *kernel;
+    queue_t queue;                          // fifo_scheduler(), rr_scheduler()
+    sjf_ready_t sjf;
+    mlfq_ready_t mlfq;
+} wrapper_t;
+
+static int wrapper_enqueue(wrapper_t *w, pcb_t *task) {
+    if (w->policy == &sjf_policy) return sjf_enqueue(&w->sjf, task);
+    if (w->policy == &mlfq_policy) {
+        task->level = 0;
+        return mlfq_enqueue(&w->mlfq, 0, task);
+    }
+    return enqueue_pcb(&w->queue, task);
+}
+
+static void wrapper_call(wrapper_t *w, uint32_t current_time_ms, pcb_t **cpu) {
+    if (w->policy == &fifo_policy) {
+        fifo_scheduler(current_time_ms, &w->queue, cpu);
+    } else if (w->policy == &sjf_policy) {
+        sjf_scheduler(current_time_ms, &w->sjf, cpu);
+    } else if (w->policy == &rr_policy) {
+        rr_scheduler(current_time_ms, &w->queue, cpu);
+    } else {
+        mlfq_scheduler(current_time_ms, &w->mlfq, cpu);
+    }
+}
+
+/**
+ * @brief Times the named entry point of a policy, one call per tick.
+ * @return 0 on success, 1 if the policy has none, -1 on error.
+ */
+static int bench_wrapper(const scheduler_policy_t *policy, const policy_config_t *config,
+                         uint32_t queue_len, uint64_t iterations, bench_result_t *result) {
+    wrapper_t w = { .policy = policy };
+    if (policy == &fifo_policy) w.kernel = "fifo_scheduler";
+    else if (policy == &sjf_policy) w.kernel = "sjf_scheduler";
+    else if (policy == &rr_policy) w.kernel = "rr_scheduler";
+    else if (policy == &mlfq_policy) w.kernel = "mlfq_scheduler";
+    else return 1;
+    if (policy == &mlfq_policy && mlfq_init(&w.mlfq, config->mlfq_levels, config->mlfq_quanta) < 0) return -1;
+
+    pcb_t **tasks = new_tasks(queue_len);
+    if (!tasks) {
+        fprintf(stderr, "Out of memory for %u tasks\n", queue_len);
+        return -1;
+    }
+    for (uint32_t i = 0; i < queue_len; i++) wrapper_enqueue(&w, tasks[i]);
+
+    pcb_t *cpu = NULL;
+    uint64_t dispatches = 0;
+    uint64_t allocations_before = allocations;
+    uint64_t start = now_ns();
+    for (uint64_t tick = 0; tick < iterations; tick++) {
+        pcb_t *prev = cpu;
+        finished_task = NULL;
+        wrapper_call(&w, (uint32_t)(tick * TICKS_MS), &cpu);
+        if (cpu && (cpu != prev || prev->preempted)) dispatches++;
+        if (prev) prev->preempted = 0;
+        if (finished_task) {
+            new_burst(finished_task);
+            wrapper_enqueue(&w, finished_task);
+        }
+    }
+    uint64_t elapsed = now_ns() - start;
+    *result = (bench_result_t){ w.kernel, queue_len, iterations, elapsed, dispatches, allocations - allocations_before };
+
+    // Give the queue elements back to the free list before the tasks go away
+    while (dequeue_pcb(&w.queue) != NULL) {}
+    for (uint32_t l = 0; l < w.mlfq.num_levels; l++) {
+        while (dequeue_pcb(&w.mlfq.levels[l]) != NULL) {}
+    }
+    free(w.sjf.heap);
+    free_tasks(tasks, queue_len);
+    return 0;
+}
+
+/**
+ * @brief Moves the head of the queue to its tail, as a FIFO or RR ready queue does on every dispatch.
+ */
+static int bench_enqueue_dequeue(uint32_t queue_len, uint64_t iterations, bench_result_t *result) {
+    pcb_t **tasks = new_tasks(queue_len);
+    if (!tasks) return -1;
+    queue_t q = {0};
+    for (uint32_t i = 0; i < queue_len; i++) enqueue_pcb(&q, tasks[i]);
+
+    uint64_t allocations_before = allocations;
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < iterations; i++) {
+        enqueue_pcb(&q, dequeue_pcb(&q));
+    }
+    uint64_t elapsed = now_ns() - start;
+    *result = (bench_result_t){ "enqueue_dequeue", queue_len, iterations, elapsed, 0, allocations - allocations_before };
+
+    while (dequeue_pcb(&q) != NULL) {}
+    free_tasks(tasks, queue_len);
+    return 0;
+}
+
+/**
+ * @brief Unlinks a random task and appends it again, as a task leaving a queue out of order.
+ */
+static int bench_remove_queue_elem(uint32_t queue_len, uint64_t iterations, bench_result_t *result) {
+    pcb_t **tasks = new_tasks(queue_len);
+    if (!tasks) return -1;
+    queue_t q = {0};
+    for (uint32_t i = 0; i < queue_len; i++) enqueue_pcb(&q, tasks[i]);
+
+    uint32_t *picks = malloc(iterations * sizeof(uint32_t));   // Drawn up front to keep them out of the timing
+    if (!picks) {
+        free_tasks(tasks, queue_len);
+        return -1;
+    }
+    for (uint64_t i = 0; i < iterations; i++) picks[i] = next_random() % queue_len;
+
+    uint64_t allocations_before = allocations;
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < iterations; i++) {
+        pcb_t *task = tasks[picks[i]];
+        free_queue_elem(remove_queue_elem(&q, task->elem));
+        enqueue_pcb(&q, task);
+    }
+    uint64_t elapsed = now_ns() - start;
+    *result = (bench_result_t){ "remove_queue_elem", queue_len, iterations, elapsed, 0, allocations - allocations_before };
+
+    free(picks);
+    while (dequeue_pcb(&q) != NULL) {}
+    free_tasks(tasks, queue_len);
+    return 0;
+}
+
+static void print_result(FILE *out, const bench_result_t *r) {
+    fprintf(out, "%s,%u,%llu,%.1f,", r->kernel, r->queue_len, (unsigned long long)r->iterations,
+            (double)r->elapsed_ns / (double)r->iterations);
+    if (r->dispatches > 0) {
+        fprintf(out, "%llu,%.1f,", (unsigned long long)r->dispatches, (double)r->elapsed_ns / (double)r->dispatches);
+    } else {
+        fprintf(out, ",,");
+    }
+    fprintf(out, "%.4f\n", (double)r->allocations / (double)r->iterations);
+    fflush(out);
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("Times the scheduling policies and the ready queue primitives with synthetic ready queues\n");
+    printf("  -p, --policies LIST      policies to time, with their named entry points (default FIFO,SJF,RR,MLFQ)\n");
+    printf("  -s, --sizes LIST         ready queue lengths (default 10,100,1000,10000,100000,1000000)\n");
+    printf("  -i, --iterations N       ticks or queue operations per measurement (default %d)\n", DEFAULT_ITERATIONS);
+    printf("  -o, --output FILE        write the results to FILE instead of stdout\n");
+    printf("Output is CSV, one line per kernel and queue length; an operation is one tick for the\n");
+    printf("policies and their entry points, one dequeue and enqueue for enqueue_dequeue, one removal and enqueue for remove_queue_elem.\n");
+}
+
+int main(int argc, char *argv[]) {
+    const scheduler_policy_t *policies[16];
+    int num_policies = 0;
+    uint32_t sizes[MAX_BENCH_SIZES] = {10, 100, 1000, 10000, 100000, 1000000};
+    int num_sizes = 6;
+    uint64_t iterations = DEFAULT_ITERATIONS;
+    const char *output = NULL;
+
+    static const struct option long_options[] = {
+        {"policies", required_argument, NULL, 'p'},
+        {"sizes", required_argument, NULL, 's'},
+        {"iterations", required_argument, NULL, 'i'},
+        {"output", required_argument, NULL, 'o'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "p:s:i:o:", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'p': {
+                char *list = strdup(optarg);
+                for (char *name = strtok(list, ","); name; name = strtok(NULL, ",")) {
+                    const scheduler_policy_t *policy = find_policy(name);
+                    if (!policy || num_policies == (int)(sizeof(policies) / sizeof(policies[0]))) {
+                        fprintf(stderr, "Scheduler %s not recognized\n", name);
+                        exit(EXIT_FAILURE);
+                    }
+                    policies[num_policies++] = policy;
+                }
+                free(list);
+                break;
+            }
+            case 's':
+                num_sizes = parse_uint_list(optarg, sizes, MAX_BENCH_SIZES);
+                if (num_sizes <= 0) {
+                    fprintf(stderr, "Invalid queue lengths: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'i': {
+                char *endptr;
+                long long value = strtoll(optarg, &endptr, 10);
+                if (*endptr != '\0' || value <= 0) {
+                    fprintf(stderr, "Invalid number of iterations: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                iterations = (uint64_t)value;
+                break;
+            }
+            case 'o':
+                output = optarg;
+                break;
+            default:
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (optind != argc) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (num_policies == 0) {
+        for (int i = 0; SCHEDULER_POLICIES[i] != NULL; i++) policies[num_policies++] = SCHEDULER_POLICIES[i];
+    }
+
+    FILE *out = output ? fopen(output, "w") : stdout;
+    if (!out) {
+        perror("fopen");
+        return EXIT_FAILURE;
+    }
+
+    uint32_t mlfq_quanta[] = {8, 16, 1000000};
+    policy_config_t config = {
+        .rr_quantum_ms = QUANTUM_MS,
+        .mlfq_levels = 3,
+        .mlfq_quanta = mlfq_quanta,
+    };
+    set_done_handler(bench_done);
+
+    int status = EXIT_SUCCESS;
+    bench_result_t result;
+    fprintf(out, "kernel,queue_len,iterations,ns_per_op,dispatches,ns_per_dispatch,allocs_per_op\n");
+    for (int s = 0; s < num_sizes; s++) {
+        for (int p = 0; p < num_policies; p++) {
+            if (bench_policy(policies[p], &config, sizes[s], iterations, &result) < 0) {
+                status = EXIT_FAILURE;
+                continue;
+            }
+            print_result(out, &result);
+            int ret = bench_wrapper(policies[p], &config, sizes[s], iterations, &result);
+            if (ret == 0) print_result(out, &result);
+            else if (ret < 0) status = EXIT_FAILURE;
+        }
+        if (bench_enqueue_dequeue(sizes[s], iterations, &result) == 0) print_result(out, &result);
+        else status = EXIT_FAILURE;
+        if (bench_remove_queue_elem(sizes[s], iterations, &result) == 0) print_result(out, &result);
+        else status = EXIT_FAILURE;
+    }
+
+    if (out != stdout) fclose(out);
+    return status;
+}
@@ -1,52 +1,137 @@
+#include "sjf.h"
 #include "msg.h"
-#include "queue.h"
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-static pcb_t* find_shortest_job(queue_t *rq) { // essa funcao serve para procurar o processo mais curto que está na fila
-    queue_elem_t *curr = rq->head;
-    queue_elem_t *shortest_elem = curr;
+#define SJF_HEAP_INITIAL_CAPACITY 64
 
-    if (!curr) return NULL;
+static int sjf_less(const sjf_entry_t *a, const sjf_entry_t *b) {
+    if (a->pcb->time_ms != b->pcb->time_ms) return a->pcb->time_ms < b->pcb->time_ms;
+    return a->seq < b->seq;
+}
 
-    while (curr != NULL) {
-        if (curr->pcb->time_ms < shortest_elem->pcb->time_ms) {
-            shortest_elem = curr;
-        }
-        curr = curr->next;
+static void sjf_swap(sjf_entry_t *a, sjf_entry_t *b) {
+    sjf_entry_t tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+static int sjf_push(sjf_ready_t *rq, pcb_t *pcb) {
+    if (rq->count == rq->capacity) {
+        uint32_t new_capacity = rq->capacity ? rq->capacity * 2 : SJF_HEAP_INITIAL_CAPACITY;
+        sjf_entry_t *tmp = realloc(rq->heap, new_capacity * sizeof(sjf_entry_t));
+        if (!tmp) return 0;
+        rq->heap = tmp;
+        rq->capacity = new_capacity;
     }
 
-    // remove o mais curto da fila
-    queue_elem_t *removed = remove_queue_elem(rq, shortest_elem);
-    if (!removed) return NULL;
+    sjf_entry_t *heap = rq->heap;
+    uint32_t i = rq->count++;
+    heap[i] = (sjf_entry_t){ .pcb = pcb, .seq = rq->next_seq++ };
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!sjf_less(&heap[i], &heap[parent])) break;
+        sjf_swap(&heap[i], &heap[parent]);
+        i = parent;
+    }
+    return 1;
+}
+
+static pcb_t *sjf_pop(sjf_ready_t *rq) {
+    if (rq->count == 0) return NULL;
 
-    pcb_t *shortest = removed->pcb;
-    free(removed);
+    sjf_entry_t *heap = rq->heap;
+    pcb_t *shortest = heap[0].pcb;
+    heap[0] = heap[--rq->count];
+
+    uint32_t i = 0;
+    while (1) {
+        uint32_t left = 2 * i + 1;
+        uint32_t right = left + 1;
+        uint32_t smallest = i;
+        if (left < rq->count && sjf_less(&heap[left], &heap[smallest])) smallest = left;
+        if (right < rq->count && sjf_less(&heap[right], &heap[smallest])) smallest = right;
+        if (smallest == i) break;
+        sjf_swap(&heap[i], &heap[smallest]);
+        i = smallest;
+    }
     return shortest;
 }
 
-void sjf_scheduler(uint32_t current_time_ms, queue_t *rq, pcb_t **cpu_task) {
+static void sjf_tick(void *rq, uint32_t current_time_ms, pcb_t **cpu_task) {
+    (void)rq;
     if (*cpu_task) {
         (*cpu_task)->ellapsed_time_ms += TICKS_MS;
 
         if ((*cpu_task)->ellapsed_time_ms >= (*cpu_task)->time_ms) {
-            msg_t msg = {
-                .pid = (*cpu_task)->pid,
-                .request = PROCESS_REQUEST_DONE,
-                .time_ms = current_time_ms
-            };
-
-            if (write((*cpu_task)->sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
-                perror("write");
-            }
-
-            free(*cpu_task);
+            finish_burst(*cpu_task, current_time_ms);
             *cpu_task = NULL;
         }
     }
+}
+
+static pcb_t *sjf_pick(void *rq, uint32_t current_time_ms) {
+    (void)current_time_ms;
+    // remove o mais curto da fila
+    return sjf_pop((sjf_ready_t *)rq);
+}
+
+/**
+ * @brief Shortest-Job-First (SJF) scheduling algorithm.
+ *
+ * Non-preemptive: once a task gets the CPU it runs until its burst is done. When the CPU
+ * is idle, the ready task with the smallest requested time is selected, ties are broken
+ * in arrival order. Ready tasks are kept in a min-heap (see sjf_enqueue()), so each
+ * dispatch costs O(log n) instead of a scan of the whole queue.
+ *
+ * @param current_time_ms The current time in milliseconds.
+ * @param rq Pointer to the ready heap, zero-initialized before the first task is enqueued.
+ * @param cpu_task Double pointer to the currently running task.
+ */
+void sjf_scheduler(uint32_t current_time_ms, sjf_ready_t *rq, pcb_t **cpu_task) {
+    sjf_tick(rq, current_time_ms, cpu_task);
 
-    if (*cpu_task == NULL && rq->head != NULL) {
-        *cpu_task = find_shortest_job(rq);
+    if (*cpu_task == NULL) {
+        *cpu_task = sjf_pick(rq, current_time_ms);
     }
 }
+
+static void *sjf_init(const policy_config_t *config) {
+    (void)config;
+    return calloc(1, sizeof(sjf_ready_t));
+}
+
+int sjf_enqueue(sjf_ready_t *rq, pcb_t *task) {
+    return sjf_push(rq, task);
+}
+
+static int sjf_policy_enqueue(void *rq, pcb_t *task) {
+    return sjf_push((sjf_ready_t *)rq, task);
+}
+
+static uint32_t sjf_ready_count(const void *rq) {
+    return ((const sjf_ready_t *)rq)->count;
+}
+
+static uint32_t sjf_quantum_ms(const void *rq, const pcb_t *task) {
+    (void)rq;
+    (void)task;
+    return UINT32_MAX;      // Never preempted
+}
+
+static void sjf_destroy(void *rq) {
+    free(((sjf_ready_t *)rq)->heap);
+    free(rq);
+}
+
+const scheduler_policy_t sjf_policy = {
+    .name = "SJF",
+    .init = sjf_init,
+    .enqueue = sjf_policy_enqueue,
+    .tick = sjf_tick,
+    .pick = sjf_pick,
+    .ready_count = sjf_ready_count,
+    .quantum_ms = sjf_quantum_ms,
+    .destroy = sjf_destroy,
+};
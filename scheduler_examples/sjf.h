@@ -1,8 +1,31 @@
 #include <stdint.h>
+#include "policy.h"
 #include "queue.h"
 #ifndef SJF_H
 #define SJF_H
 
-void sjf_scheduler(uint32_t current_time_ms, queue_t *rq, pcb_t **cpu_task);
+// Entry of the SJF min-heap, seq keeps FIFO order between jobs of the same length
+typedef struct {
+    pcb_t *pcb;
+    uint64_t seq;
+} sjf_entry_t;
+
+// Ready tasks ordered by requested time
+typedef struct {
+    sjf_entry_t *heap;
+    uint32_t count;
+    uint32_t capacity;
+    uint64_t next_seq;
+} sjf_ready_t;
+
+/**
+ * @brief Adds a ready task to the heap.
+ * @return 1 on success, 0 if the heap could not grow.
+ */
+int sjf_enqueue(sjf_ready_t *rq, pcb_t *task);
+
+void sjf_scheduler(uint32_t current_time_ms, sjf_ready_t *rq, pcb_t **cpu_task);
+
+extern const scheduler_policy_t sjf_policy;
 
 #endif
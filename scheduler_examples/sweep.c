@@ -0,0 +1,356 @@
+#define _GNU_SOURCE                     // pthread_setaffinity_np()
+#include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "batch.h"
+#include "machine.h"
+#include "mlfq.h"
+#include "policy.h"
+#include "RR.h"
+
+#define MAX_SWEEP_VALUES 1024
+#define MLFQ_LAST_QUANTUM_MS 1000000    // Last level of generated MLFQ quanta, as in the default set
+
+// A set of MLFQ quanta, one per level
+typedef struct {
+    uint32_t quanta[MAX_MLFQ_LEVELS];
+    uint32_t levels;
+} quanta_set_t;
+
+// One point of the grid
+typedef struct {
+    const batch_scenario_t *scenario;
+    const char *scenario_file;
+    const scheduler_policy_t *policy;
+    policy_config_t config;
+    uint32_t num_cpus;
+    batch_result_t result;
+    int status;
+} sweep_job_t;
+
+typedef struct {
+    sweep_job_t *jobs;
+    uint32_t num_jobs;
+    atomic_uint next_job;           // Next job to hand out, workers take them in order
+} sweep_pool_t;
+
+static void *sweep_worker(void *arg) {
+    sweep_pool_t *pool = arg;
+    uint32_t i;
+    while ((i = atomic_fetch_add(&pool->next_job, 1)) < pool->num_jobs) {
+        sweep_job_t *job = &pool->jobs[i];
+        job->status = simulate_batch(job->scenario, job->policy, &job->config, job->num_cpus, NULL, &job->result);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Pins a worker to the n-th CPU the process may run on, so that each simulation keeps a core.
+ *
+ * With more workers than CPUs, they wrap around and share them.
+ */
+static void pin_worker(pthread_t thread, long n, const cpu_set_t *allowed) {
+    int count = CPU_COUNT(allowed);
+    if (count == 0) return;
+    int skip = (int)(n % count);
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, allowed) || skip-- > 0) continue;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        int err = pthread_setaffinity_np(thread, sizeof(set), &set);
+        if (err != 0) fprintf(stderr, "pthread_setaffinity_np: %s\n", strerror(err));
+        return;
+    }
+}
+
+static void print_quanta(FILE *out, const policy_config_t *config) {
+    for (uint32_t l = 0; l < config->mlfq_levels; l++) {
+        fprintf(out, "%s%u", l ? " " : "", config->mlfq_quanta[l]);
+    }
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [options] <scenario>...\n", prog);
+    printf("Runs every combination of the options below on every scenario (see ossim --batch)\n");
+    printf("  -p, --policies LIST      policies to compare (default FIFO,SJF,RR,MLFQ)\n");
+    printf("  -r, --rr-quanta LIST     Round-Robin time slices in ms (default %d)\n", QUANTUM_MS);
+    printf("  -q, --mlfq-quanta SETS   MLFQ quanta sets separated by ';', e.g. \"8,16,1000000;10,20,1000000\"\n");
+    printf("  -l, --mlfq-levels LIST   generate MLFQ sets with these level counts, doubling the base\n");
+    printf("                           quantum at each level and ending with a %d ms level\n", MLFQ_LAST_QUANTUM_MS);
+    printf("  -b, --mlfq-base LIST     base quanta in ms of the generated MLFQ sets (default 8)\n");
+    printf("  -n, --cpus LIST          CPU counts of the simulated machine (default 1)\n");
+    printf("  -j, --jobs N             simulations run in parallel, each pinned to a core (default: one per online core)\n");
+    printf("  -o, --output FILE        write the results table to FILE instead of stdout\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *policies_arg = "FIFO,SJF,RR,MLFQ";
+    const char *quanta_arg = NULL;
+    const char *output_file = NULL;
+    static uint32_t rr_quanta[MAX_SWEEP_VALUES] = {QUANTUM_MS};
+    int num_rr_quanta = 1;
+    static uint32_t mlfq_levels[MAX_SWEEP_VALUES];
+    int num_mlfq_levels = 0;
+    static uint32_t mlfq_bases[MAX_SWEEP_VALUES] = {8};
+    int num_mlfq_bases = 1;
+    static uint32_t cpu_counts[MAX_SWEEP_VALUES] = {1};
+    int num_cpu_counts = 1;
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+
+    static const struct option long_options[] = {
+        {"policies", required_argument, NULL, 'p'},
+        {"rr-quanta", required_argument, NULL, 'r'},
+        {"mlfq-quanta", required_argument, NULL, 'q'},
+        {"mlfq-levels", required_argument, NULL, 'l'},
+        {"mlfq-base", required_argument, NULL, 'b'},
+        {"cpus", required_argument, NULL, 'n'},
+        {"jobs", required_argument, NULL, 'j'},
+        {"output", required_argument, NULL, 'o'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "p:r:q:l:b:n:j:o:", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'p':
+                policies_arg = optarg;
+                break;
+            case 'r':
+                num_rr_quanta = parse_uint_list(optarg, rr_quanta, MAX_SWEEP_VALUES);
+                if (num_rr_quanta <= 0) {
+                    fprintf(stderr, "Invalid RR quanta: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'q':
+                quanta_arg = optarg;
+                break;
+            case 'l':
+                num_mlfq_levels = parse_uint_list(optarg, mlfq_levels, MAX_SWEEP_VALUES);
+                if (num_mlfq_levels <= 0) {
+                    fprintf(stderr, "Invalid MLFQ level counts: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                for (int i = 0; i < num_mlfq_levels; i++) {
+                    if (mlfq_levels[i] > MAX_MLFQ_LEVELS) {
+                        fprintf(stderr, "MLFQ supports at most %d levels\n", MAX_MLFQ_LEVELS);
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                break;
+            case 'b':
+                num_mlfq_bases = parse_uint_list(optarg, mlfq_bases, MAX_SWEEP_VALUES);
+                if (num_mlfq_bases <= 0) {
+                    fprintf(stderr, "Invalid MLFQ base quanta: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'n':
+                num_cpu_counts = parse_uint_list(optarg, cpu_counts, MAX_SWEEP_VALUES);
+                if (num_cpu_counts <= 0) {
+                    fprintf(stderr, "Invalid CPU counts: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                for (int i = 0; i < num_cpu_counts; i++) {
+                    if (cpu_counts[i] > MAX_CPUS) {
+                        fprintf(stderr, "At most %d CPUs are supported\n", MAX_CPUS);
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                break;
+            case 'j': {
+                char *endptr;
+                jobs = strtol(optarg, &endptr, 10);
+                if (*endptr != '\0' || jobs <= 0) {
+                    fprintf(stderr, "Invalid number of jobs: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            }
+            case 'o':
+                output_file = optarg;
+                break;
+            default:
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (optind >= argc) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (jobs <= 0) jobs = 1;
+
+    // Policies
+    const scheduler_policy_t *policies[16];
+    int num_policies = 0;
+    char *policies_copy = strdup(policies_arg);
+    if (!policies_copy) {
+        perror("strdup");
+        exit(EXIT_FAILURE);
+    }
+    for (char *name = strtok(policies_copy, ","); name; name = strtok(NULL, ",")) {
+        const scheduler_policy_t *policy = find_policy(name);
+        if (!policy || num_policies == (int)(sizeof(policies) / sizeof(policies[0]))) {
+            fprintf(stderr, "Scheduler %s not recognized\n", name);
+            exit(EXIT_FAILURE);
+        }
+        policies[num_policies++] = policy;
+    }
+    free(policies_copy);
+
+    // MLFQ quanta sets, explicit ones first, then the generated ones
+    quanta_set_t *sets = calloc(MAX_SWEEP_VALUES, sizeof(quanta_set_t));
+    if (!sets) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    int num_sets = 0;
+    if (quanta_arg) {
+        char *quanta_copy = strdup(quanta_arg);
+        if (!quanta_copy) {
+            perror("strdup");
+            exit(EXIT_FAILURE);
+        }
+        for (char *list = strtok(quanta_copy, ";"); list; list = strtok(NULL, ";")) {
+            int levels = num_sets < MAX_SWEEP_VALUES ? mlfq_parse_quanta(list, sets[num_sets].quanta) : -1;
+            if (levels <= 0) {
+                fprintf(stderr, "Invalid MLFQ quanta: %s\n", list);
+                exit(EXIT_FAILURE);
+            }
+            sets[num_sets++].levels = (uint32_t)levels;
+        }
+        free(quanta_copy);
+    }
+    for (int l = 0; l < num_mlfq_levels; l++) {
+        for (int b = 0; b < num_mlfq_bases && num_sets < MAX_SWEEP_VALUES; b++) {
+            quanta_set_t *set = &sets[num_sets++];
+            set->levels = mlfq_levels[l];
+            for (uint32_t i = 0; i + 1 < set->levels; i++) {
+                uint64_t quantum = (uint64_t)mlfq_bases[b] << i;
+                set->quanta[i] = quantum < MLFQ_LAST_QUANTUM_MS ? (uint32_t)quantum : MLFQ_LAST_QUANTUM_MS;
+            }
+            set->quanta[set->levels - 1] = MLFQ_LAST_QUANTUM_MS;
+        }
+    }
+    if (num_sets == 0) {
+        sets[num_sets++] = (quanta_set_t){ .quanta = {8, 16, MLFQ_LAST_QUANTUM_MS}, .levels = 3 };
+    }
+
+    // Scenarios are loaded once and shared read-only by all the workers
+    int num_scenarios = argc - optind;
+    batch_scenario_t **scenarios = calloc(num_scenarios, sizeof(batch_scenario_t *));
+    if (!scenarios) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    for (int s = 0; s < num_scenarios; s++) {
+        scenarios[s] = load_scenario(argv[optind + s]);
+        if (!scenarios[s]) exit(EXIT_FAILURE);
+    }
+
+    // The grid, in output order
+    sweep_pool_t pool = {0};
+    uint32_t max_jobs = (uint32_t)num_scenarios * num_cpu_counts * num_policies * (num_rr_quanta + num_sets);
+    pool.jobs = calloc(max_jobs, sizeof(sweep_job_t));
+    if (!pool.jobs) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    for (int s = 0; s < num_scenarios; s++) {
+        for (int n = 0; n < num_cpu_counts; n++) {
+            for (int p = 0; p < num_policies; p++) {
+                // Only the parameters a policy reads are swept for it
+                int variants = policies[p] == &rr_policy ? num_rr_quanta : policies[p] == &mlfq_policy ? num_sets : 1;
+                for (int v = 0; v < variants; v++) {
+                    sweep_job_t *job = &pool.jobs[pool.num_jobs++];
+                    job->scenario = scenarios[s];
+                    job->scenario_file = argv[optind + s];
+                    job->num_cpus = cpu_counts[n];
+                    job->policy = policies[p];
+                    job->config.rr_quantum_ms = policies[p] == &rr_policy ? rr_quanta[v] : QUANTUM_MS;
+                    const quanta_set_t *set = policies[p] == &mlfq_policy ? &sets[v] : &sets[0];
+                    job->config.mlfq_levels = set->levels;
+                    job->config.mlfq_quanta = set->quanta;
+                }
+            }
+        }
+    }
+
+    if ((uint32_t)jobs > pool.num_jobs) jobs = pool.num_jobs;
+    fprintf(stderr, "Running %u simulations on %ld threads\n", pool.num_jobs, jobs);
+
+    struct timespec wall_start, wall_end;
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) < 0) {
+        perror("sched_getaffinity");
+        CPU_ZERO(&allowed);             // Leave the workers unpinned
+    }
+    pthread_t *threads = calloc(jobs, sizeof(pthread_t));
+    long started = 0;
+    for (; threads && started < jobs; started++) {
+        if (pthread_create(&threads[started], NULL, sweep_worker, &pool) != 0) {
+            perror("pthread_create");
+            break;
+        }
+        pin_worker(threads[started], started, &allowed);
+    }
+    if (started == 0) {
+        sweep_worker(&pool);            // No threads at all, run the grid here
+    }
+    for (long t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    double wall_s = (double)(wall_end.tv_sec - wall_start.tv_sec) + (wall_end.tv_nsec - wall_start.tv_nsec) / 1e9;
+
+    FILE *out = stdout;
+    if (output_file) {
+        out = fopen(output_file, "w");
+        if (!out) {
+            perror("fopen");
+            exit(EXIT_FAILURE);
+        }
+    }
+    int failed = 0;
+    fprintf(out, "scenario,cpus,policy,rr_quantum_ms,mlfq_quanta_ms,apps,makespan_ms,avg_elapsed_s,max_elapsed_s,"
+                 "turnaround_p50_ms,turnaround_p95_ms,turnaround_p99_ms,wait_p95_ms,response_p95_ms,"
+                 "cpu_utilization,context_switches,migrations,wall_s\n");
+    for (uint32_t i = 0; i < pool.num_jobs; i++) {
+        const sweep_job_t *job = &pool.jobs[i];
+        fprintf(out, "%s,%u,%s,", job->scenario_file, job->num_cpus, job->policy->name);
+        if (job->policy == &rr_policy) fprintf(out, "%u", job->config.rr_quantum_ms);
+        fprintf(out, ",");
+        if (job->policy == &mlfq_policy) print_quanta(out, &job->config);
+        if (job->status == 0) {
+            const metrics_summary_t *m = &job->result.metrics;
+            fprintf(out, ",%u,%u,%.03f,%.03f,%u,%u,%u,%u,%u,%.4f,%u,%llu,%.03f\n", job->result.apps,
+                    job->result.makespan_ms, job->result.avg_elapsed_s, job->result.max_elapsed_s,
+                    m->task_turnaround.p50, m->task_turnaround.p95, m->task_turnaround.p99,
+                    m->task_wait.p95, m->task_response.p95, m->cpu_utilization, m->context_switches,
+                    (unsigned long long)job->result.migrations, job->result.wall_s);
+        } else {
+            fprintf(out, ",,,,,,,,,,,,,\n");
+            failed++;
+        }
+    }
+    if (out != stdout) fclose(out);
+    fprintf(stderr, "%u simulations finished in %.03f seconds, %d failed\n", pool.num_jobs, wall_s, failed);
+
+    free(threads);
+    free(pool.jobs);
+    for (int s = 0; s < num_scenarios; s++) free_scenario(scenarios[s]);
+    free(scenarios);
+    free(sets);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
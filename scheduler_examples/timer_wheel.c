@@ -0,0 +1,45 @@
+#include "timer_wheel.h"
+
+#include <stddef.h>
+
+#include "msg.h"
+
+static queue_t *slot_of(timer_wheel_t *w, uint32_t time_ms) {
+    return &w->slots[(time_ms / TICKS_MS) % TIMER_WHEEL_SLOTS];
+}
+
+/**
+ * @brief Adds a blocked task to the wheel, in the slot of pcb->wake_time_ms.
+ *
+ * @return 1 on success, 0 on allocation failure.
+ */
+int timer_wheel_add(timer_wheel_t *w, pcb_t *pcb) {
+    if (!enqueue_pcb(slot_of(w, pcb->wake_time_ms), pcb)) return 0;
+    w->count++;
+    return 1;
+}
+
+/**
+ * @brief Moves every task whose wake-up time has been reached to the expired queue.
+ *
+ * Only the slot of the current tick is visited, so the caller must call this on every tick
+ * where a task may wake up. Tasks keep the order in which they were blocked.
+ *
+ * @param w Pointer to the timer wheel.
+ * @param current_time_ms The current time in milliseconds.
+ * @param expired Queue receiving the tasks that wake up now.
+ */
+void timer_wheel_expire(timer_wheel_t *w, uint32_t current_time_ms, queue_t *expired) {
+    queue_t *slot = slot_of(w, current_time_ms);
+    queue_elem_t *elem = slot->head;
+    while (elem != NULL) {
+        pcb_t *pcb = elem->pcb;
+        queue_elem_t *tmp = elem;
+        elem = elem->next;
+        if (pcb->wake_time_ms <= current_time_ms) {
+            free_queue_elem(remove_queue_elem(slot, tmp));
+            enqueue_pcb(expired, pcb);
+            w->count--;
+        }
+    }
+}
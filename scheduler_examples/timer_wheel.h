@@ -0,0 +1,23 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+#include "queue.h"
+
+#define TIMER_WHEEL_SLOTS 1024      // One slot per tick, wraps around every 1024 ticks
+
+/*
+ * Hashed timing wheel holding blocked tasks keyed on their absolute wake-up time.
+ * A task lives in the slot of its wake-up tick, so expiring a tick only visits the
+ * tasks of that slot: the ones waking up now and the (rare) ones a whole number of
+ * wheel turns later.
+ */
+typedef struct {
+    queue_t slots[TIMER_WHEEL_SLOTS];
+    uint32_t count;                 // Number of tasks in the wheel
+} timer_wheel_t;
+
+int timer_wheel_add(timer_wheel_t *w, pcb_t *pcb);
+void timer_wheel_expire(timer_wheel_t *w, uint32_t current_time_ms, queue_t *expired);
+
+#endif //TIMER_WHEEL_H
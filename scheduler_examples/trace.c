@@ -0,0 +1,109 @@
+#include "trace.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(trace_record_t) == 32, "trace records must stay 32 bytes");
+_Static_assert(sizeof(trace_header_t) == 64, "trace header must stay 64 bytes");
+
+static trace_header_t *trace_header = NULL;
+static trace_record_t *trace_records = NULL;
+static size_t trace_map_size = 0;
+static uint64_t trace_mask = 0;
+
+static const char *const TRACE_EVENT_NAMES[TRACE_EVENT_TYPES] = {
+    [TRACE_ENQUEUE] = "ENQUEUE",
+    [TRACE_DISPATCH] = "DISPATCH",
+    [TRACE_PREEMPT] = "PREEMPT",
+    [TRACE_BLOCK] = "BLOCK",
+    [TRACE_WAKE] = "WAKE",
+    [TRACE_DONE] = "DONE",
+    [TRACE_ACK] = "ACK",
+};
+
+const char *trace_event_name(trace_event_en type) {
+    return type < TRACE_EVENT_TYPES ? TRACE_EVENT_NAMES[type] : "UNKNOWN";
+}
+
+int trace_open(const char *path, uint32_t records) {
+    uint32_t capacity = 1;
+    while (capacity < records && capacity < (1u << 31)) capacity <<= 1;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        perror("open trace");
+        return -1;
+    }
+    size_t size = sizeof(trace_header_t) + (size_t)capacity * sizeof(trace_record_t);
+    if (ftruncate(fd, (off_t)size) < 0) {
+        perror("ftruncate trace");
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);                          // The mapping keeps the file alive
+    if (map == MAP_FAILED) {
+        perror("mmap trace");
+        return -1;
+    }
+
+    trace_header = map;
+    memcpy(trace_header->magic, TRACE_MAGIC, sizeof(trace_header->magic));
+    trace_header->record_size = sizeof(trace_record_t);
+    trace_header->capacity = capacity;
+    trace_header->head = 0;
+    trace_records = (trace_record_t *)(trace_header + 1);
+    trace_map_size = size;
+    trace_mask = capacity - 1;
+    return 0;
+}
+
+static void trace_record(trace_event_en type, uint32_t time_ms, const pcb_t *task, uint32_t cpu, uint32_t arg,
+                         uint32_t ready_count, uint32_t blocked_count) {
+    uint64_t seq = trace_header->head;
+    trace_record_t *r = &trace_records[seq & trace_mask];
+    r->time_ms = time_ms;
+    r->pid = task ? task->pid : 0;
+    r->type = (uint8_t)type;
+    r->level = task ? task->level : 0;
+    r->cpu = (uint16_t)cpu;
+    r->arg = arg;
+    r->ready_count = ready_count;
+    r->blocked_count = blocked_count;
+    r->seq = seq;                       // Last, so a record torn by a crash does not look valid
+    trace_header->head = seq + 1;
+}
+
+void trace_event(trace_event_en type, uint32_t time_ms, const pcb_t *task, uint32_t arg,
+                 uint32_t ready_count, uint32_t blocked_count) {
+    if (!trace_header) return;
+    uint32_t cpu = task && task->cpu <= UINT16_MAX ? task->cpu : 0;
+    trace_record(type, time_ms, task, cpu, arg, ready_count, blocked_count);
+}
+
+void trace_cpu_switch(const pcb_t *prev, const pcb_t *cpu, int preempted, uint32_t cpu_index, uint32_t time_ms,
+                      uint32_t ready_count, uint32_t blocked_count) {
+    if (!trace_header || (prev == cpu && !preempted)) return;
+
+    if (prev) {
+        if (prev->status == TASK_STOPPED) {
+            trace_record(TRACE_DONE, time_ms, prev, cpu_index, prev->time_ms, ready_count, blocked_count);
+        } else {
+            trace_record(TRACE_PREEMPT, time_ms, prev, cpu_index, prev->ellapsed_time_ms, ready_count, blocked_count);
+        }
+    }
+    if (cpu) {
+        trace_record(TRACE_DISPATCH, time_ms, cpu, cpu_index, cpu->time_ms - cpu->ellapsed_time_ms, ready_count,
+                     blocked_count);
+    }
+}
+
+void trace_close(void) {
+    if (!trace_header) return;
+    munmap(trace_header, trace_map_size);
+    trace_header = NULL;
+    trace_records = NULL;
+}
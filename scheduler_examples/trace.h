@@ -0,0 +1,78 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include "queue.h"
+
+#define TRACE_MAGIC "OSTRACE1"
+#define TRACE_DEFAULT_RECORDS (1u << 20)    // 32 MiB of records
+
+// Scheduling decisions recorded in the trace
+typedef enum {
+    TRACE_ENQUEUE = 0,      // RUN request accepted, the task entered the ready queue (arg: burst ms)
+    TRACE_DISPATCH,         // Task got the CPU (arg: ms left in its burst)
+    TRACE_PREEMPT,          // Task lost the CPU before finishing its burst (arg: ms run so far)
+    TRACE_BLOCK,            // BLOCK request accepted (arg: wake-up time)
+    TRACE_WAKE,             // Blocked task finished its I/O wait
+    TRACE_DONE,             // Task finished its CPU burst (arg: burst ms)
+    TRACE_ACK,              // ACK sent to the task (arg: requested ms)
+    TRACE_EVENT_TYPES
+} trace_event_en;
+
+// One fixed-size record
+typedef struct {
+    uint64_t seq;           // Position in the trace, tells records of this lap from stale ones
+    uint32_t time_ms;       // Simulation time
+    int32_t pid;
+    uint8_t type;           // trace_event_en
+    uint8_t level;          // MLFQ level of the task
+    uint16_t cpu;           // CPU of the event, or whose ready queue holds the task
+    uint32_t arg;           // Depends on the type, see trace_event_en
+    uint32_t ready_count;   // Tasks in the ready queue after the event
+    uint32_t blocked_count; // Tasks blocked on I/O after the event
+} trace_record_t;
+
+// Start of the trace file, followed by capacity records
+typedef struct {
+    char magic[8];          // TRACE_MAGIC
+    uint32_t record_size;   // sizeof(trace_record_t)
+    uint32_t capacity;      // Number of records, a power of two
+    uint64_t head;          // Sequence number of the next record, records wrap around
+    uint8_t reserved[40];
+} trace_header_t;
+
+/**
+ * @brief Creates the trace file and maps it, enabling trace_event().
+ *
+ * The file holds a header and a ring of records. Recording only writes to the mapping, so
+ * the hot path makes no system calls; the kernel writes the pages back to the file.
+ *
+ * @param path File to create (truncated if it exists).
+ * @param records Capacity of the ring, rounded up to a power of two.
+ * @return 0 on success, -1 on error.
+ */
+int trace_open(const char *path, uint32_t records);
+
+/**
+ * @brief Appends a record to the trace. Does nothing if no trace is open.
+ */
+void trace_event(trace_event_en type, uint32_t time_ms, const pcb_t *task, uint32_t arg,
+                 uint32_t ready_count, uint32_t blocked_count);
+
+/**
+ * @brief Records CPU cpu_index moving from prev to cpu, see metrics_cpu_switch().
+ *
+ * A preempted task that gets the CPU back at once is recorded as a PREEMPT and a DISPATCH, so
+ * every expired quantum, and the MLFQ level the task ends up at, shows in the trace.
+ */
+void trace_cpu_switch(const pcb_t *prev, const pcb_t *cpu, int preempted, uint32_t cpu_index, uint32_t time_ms,
+                      uint32_t ready_count, uint32_t blocked_count);
+
+/**
+ * @brief Unmaps the trace and closes the file.
+ */
+void trace_close(void);
+
+const char *trace_event_name(trace_event_en type);
+
+#endif //TRACE_H
@@ -0,0 +1,81 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+/**
+ * @brief Decodes a trace written by ossim --trace and prints one line per record, oldest first.
+ *
+ * Only the last lap of the ring survives: when the trace wrapped, the records before
+ * head - capacity were overwritten. Slots whose sequence number does not match (never written,
+ * or torn by a crash) are skipped.
+ */
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        printf("Usage: %s <trace-file>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int fd = open(argv[1], O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return EXIT_FAILURE;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    if ((size_t)st.st_size < sizeof(trace_header_t)) {
+        fprintf(stderr, "%s is too small to be a trace\n", argv[1]);
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    const void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return EXIT_FAILURE;
+    }
+
+    const trace_header_t *header = map;
+    if (memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->record_size != sizeof(trace_record_t) || header->capacity == 0 ||
+        (header->capacity & (header->capacity - 1)) != 0 ||
+        sizeof(trace_header_t) + (size_t)header->capacity * sizeof(trace_record_t) > (size_t)st.st_size) {
+        fprintf(stderr, "%s is not a trace of this version\n", argv[1]);
+        munmap((void *)map, (size_t)st.st_size);
+        return EXIT_FAILURE;
+    }
+
+    const trace_record_t *records = (const trace_record_t *)(header + 1);
+    uint64_t head = header->head;
+    uint64_t first = head > header->capacity ? head - header->capacity : 0;
+    uint64_t skipped = 0;
+
+    printf("%12s %10s %-8s %7s %4s %5s %10s %7s %7s\n", "seq", "time_ms", "event", "pid", "cpu", "level", "arg",
+           "ready", "blocked");
+    for (uint64_t seq = first; seq < head; seq++) {
+        const trace_record_t *r = &records[seq & (header->capacity - 1)];
+        if (r->seq != seq) {
+            skipped++;
+            continue;
+        }
+        printf("%12llu %10u %-8s %7d %4u %5u %10u %7u %7u\n", (unsigned long long)r->seq, r->time_ms,
+               trace_event_name((trace_event_en)r->type), r->pid, r->cpu, r->level, r->arg, r->ready_count,
+               r->blocked_count);
+    }
+    if (first > 0 || skipped > 0) {
+        fprintf(stderr, "%llu older records overwritten, %llu invalid records skipped\n",
+                (unsigned long long)first, (unsigned long long)skipped);
+    }
+
+    munmap((void *)map, (size_t)st.st_size);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,419 @@
+#include "transport.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "msg.h"
+
+_Static_assert(sizeof(shm_ring_t) % 64 == 0, "rings must stay cache-line aligned");
+_Static_assert((SHM_RING_BYTES & (SHM_RING_BYTES - 1)) == 0, "SHM_RING_BYTES must be a power of two");
+_Static_assert(SHM_MAX_CLIENTS % 64 == 0, "pending slots are tracked 64 per word");
+
+/*
+ * Futexes live in the shared mapping, so the non-private operations are used: the kernel
+ * keys them on the underlying page, which both processes see.
+ */
+static int futex_wait(_Atomic uint32_t *word, uint32_t expected, int timeout_ms) {
+    struct timespec ts, *tsp = NULL;
+    if (timeout_ms >= 0) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+        tsp = &ts;
+    }
+    return (int)syscall(SYS_futex, word, FUTEX_WAIT, expected, tsp, NULL, 0);
+}
+
+static void futex_wake(_Atomic uint32_t *word) {
+    syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+uint32_t shm_ring_available(const shm_ring_t *ring) {
+    return atomic_load(&ring->head) - atomic_load(&ring->tail);
+}
+
+size_t shm_ring_write(shm_ring_t *ring, const void *buf, size_t len) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    uint32_t room = SHM_RING_BYTES - (head - tail);
+    uint32_t n = len < room ? (uint32_t)len : room;
+    if (n == 0) return 0;
+
+    uint32_t offset = head & (SHM_RING_BYTES - 1);
+    uint32_t first = n < SHM_RING_BYTES - offset ? n : SHM_RING_BYTES - offset;
+    memcpy(ring->data + offset, buf, first);
+    memcpy(ring->data, (const uint8_t *)buf + first, n - first);
+
+    // Sequentially consistent, so that either the consumer sees the data or we see it waiting
+    atomic_store(&ring->head, head + n);
+    if (atomic_load(&ring->reader_waiting)) futex_wake(&ring->head);
+    return n;
+}
+
+size_t shm_ring_read(shm_ring_t *ring, void *buf, size_t len) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t n = len < head - tail ? (uint32_t)len : head - tail;
+    if (n == 0) return 0;
+
+    uint32_t offset = tail & (SHM_RING_BYTES - 1);
+    uint32_t first = n < SHM_RING_BYTES - offset ? n : SHM_RING_BYTES - offset;
+    memcpy(buf, ring->data + offset, first);
+    memcpy((uint8_t *)buf + first, ring->data, n - first);
+
+    atomic_store(&ring->tail, tail + n);
+    if (atomic_load(&ring->writer_waiting)) futex_wake(&ring->tail);
+    return n;
+}
+
+int shm_ring_wait_readable(shm_ring_t *ring, int timeout_ms) {
+    for (int i = 0; i < SHM_SPIN_LOOPS; i++) {
+        if (shm_ring_available(ring) > 0) return 0;
+    }
+    atomic_store(&ring->reader_waiting, 1);
+    uint32_t head = atomic_load(&ring->head);
+    if (head == atomic_load(&ring->tail)) {
+        futex_wait(&ring->head, head, timeout_ms);
+    }
+    atomic_store(&ring->reader_waiting, 0);
+    return shm_ring_available(ring) > 0 ? 0 : -1;
+}
+
+/**
+ * @brief Waits until a ring has room for at least one byte, see shm_ring_wait_readable().
+ */
+static int shm_ring_wait_writable(shm_ring_t *ring, int timeout_ms) {
+    for (int i = 0; i < SHM_SPIN_LOOPS; i++) {
+        if (shm_ring_available(ring) < SHM_RING_BYTES) return 0;
+    }
+    atomic_store(&ring->writer_waiting, 1);
+    uint32_t tail = atomic_load(&ring->tail);
+    if (atomic_load(&ring->head) - tail == SHM_RING_BYTES) {
+        futex_wait(&ring->tail, tail, timeout_ms);
+    }
+    atomic_store(&ring->writer_waiting, 0);
+    return shm_ring_available(ring) < SHM_RING_BYTES ? 0 : -1;
+}
+
+static int any_pending(shm_region_t *region) {
+    if (atomic_load(&region->notified)) return 1;
+    for (uint32_t i = 0; i < SHM_MAX_CLIENTS / 64; i++) {
+        if (atomic_load(&region->pending[i])) return 1;
+    }
+    return 0;
+}
+
+shm_region_t *shm_server_open(void) {
+    shm_unlink(SHM_PATH);           // A segment left behind by a simulator that crashed
+    int fd = shm_open(SHM_PATH, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        perror("shm_open");
+        return NULL;
+    }
+    if (ftruncate(fd, sizeof(shm_region_t)) < 0) {
+        perror("ftruncate shm");
+        close(fd);
+        shm_unlink(SHM_PATH);
+        return NULL;
+    }
+    shm_region_t *region = mmap(NULL, sizeof(shm_region_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED) {
+        perror("mmap shm");
+        shm_unlink(SHM_PATH);
+        return NULL;
+    }
+    // The segment starts zeroed: all slots free, all rings empty
+    region->slots = SHM_MAX_CLIENTS;
+    atomic_thread_fence(memory_order_release);
+    memcpy(region->magic, SHM_MAGIC, sizeof(region->magic));
+    return region;
+}
+
+void shm_server_close(shm_region_t *region) {
+    atomic_store(&region->closed, 1);
+    for (uint32_t i = 0; i < SHM_MAX_CLIENTS; i++) {
+        if (atomic_load(&region->slot[i].to_app.reader_waiting)) futex_wake(&region->slot[i].to_app.head);
+    }
+    munmap(region, sizeof(shm_region_t));
+    shm_unlink(SHM_PATH);
+}
+
+void shm_server_collect(shm_region_t *region, uint64_t pending[SHM_MAX_CLIENTS / 64]) {
+    atomic_store(&region->notified, 0);
+    for (uint32_t i = 0; i < SHM_MAX_CLIENTS / 64; i++) {
+        if (atomic_load_explicit(&region->pending[i], memory_order_relaxed)) {
+            pending[i] |= atomic_exchange(&region->pending[i], 0);
+        }
+    }
+}
+
+int shm_server_wait(shm_region_t *region, int timeout_ms) {
+    if (timeout_ms == 0) return any_pending(region);
+
+    uint32_t doorbell = atomic_load(&region->doorbell);
+    atomic_store(&region->sim_waiting, 1);
+    int ret = 1;
+    if (!any_pending(region)) {
+        if (futex_wait(&region->doorbell, doorbell, timeout_ms) < 0 && errno == ETIMEDOUT) {
+            ret = any_pending(region);
+        }
+    }
+    atomic_store(&region->sim_waiting, 0);
+    return ret;
+}
+
+void shm_server_notify(shm_region_t *region) {
+    atomic_store(&region->notified, 1);
+    atomic_fetch_add(&region->doorbell, 1);
+    if (atomic_load(&region->sim_waiting)) futex_wake(&region->doorbell);
+}
+
+/**
+ * @brief Tells whether the application that claimed a slot still runs.
+ *
+ * A pidfd is readable as soon as the process exits, while kill(pid, 0) still succeeds on a zombie
+ * that its parent did not reap yet; kill() is only the fallback for kernels without pidfd_open.
+ * An unknown owner (0) has just claimed the slot and counts as alive.
+ */
+static int owner_alive(int32_t pid) {
+    if (pid <= 0) return 1;
+    int fd = (int)syscall(SYS_pidfd_open, pid, 0);
+    if (fd < 0) {
+        if (errno == ESRCH) return 0;
+        return kill(pid, 0) == 0 || errno == EPERM;
+    }
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    int exited = poll(&pfd, 1, 0) > 0;
+    close(fd);
+    return !exited;
+}
+
+void shm_server_release(shm_region_t *region, uint32_t index) {
+    shm_slot_t *slot = &region->slot[index];
+    uint32_t state = SHM_SLOT_OPEN;
+    if (atomic_compare_exchange_strong(&slot->state, &state, SHM_SLOT_DROPPED)) state = SHM_SLOT_DROPPED;
+    if (state == SHM_SLOT_DROPPED && owner_alive(atomic_load(&slot->owner))) {
+        // Wake the application if it waits for a message, it finds the slot dropped and closes it
+        if (atomic_load(&slot->to_app.reader_waiting)) futex_wake(&slot->to_app.head);
+        return;
+    }
+
+    shm_ring_t *rings[] = {&slot->to_sim, &slot->to_app};
+    for (int i = 0; i < 2; i++) {
+        atomic_store(&rings[i]->head, 0);
+        atomic_store(&rings[i]->tail, 0);
+        atomic_store(&rings[i]->reader_waiting, 0);
+        atomic_store(&rings[i]->writer_waiting, 0);
+    }
+    atomic_store(&slot->owner, 0);
+    atomic_store(&slot->state, SHM_SLOT_FREE);
+}
+
+void shm_server_reap(shm_region_t *region, uint64_t pending[SHM_MAX_CLIENTS / 64]) {
+    for (uint32_t i = 0; i < SHM_MAX_CLIENTS; i++) {
+        shm_slot_t *slot = &region->slot[i];
+        uint32_t state = atomic_load_explicit(&slot->state, memory_order_relaxed);
+        if (state != SHM_SLOT_OPEN && state != SHM_SLOT_DROPPED) continue;
+        if (owner_alive(atomic_load(&slot->owner))) continue;
+        if (atomic_compare_exchange_strong(&slot->state, &state, SHM_SLOT_CLOSED)) {
+            pending[i / 64] |= 1ull << (i % 64);
+        }
+    }
+}
+
+int listen_socket(const char *socket_path, int backlog) {
+    int server_fd;
+    struct sockaddr_un addr;
+
+    unlink(socket_path);
+
+    if ((server_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(struct sockaddr_un));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+
+    if (bind(server_fd, (struct sockaddr *) &addr, sizeof(struct sockaddr_un)) < 0) {
+        perror("bind");
+        close(server_fd);
+        return -1;
+    }
+
+    if (listen(server_fd, backlog) < 0) {
+        perror("listen");
+        close(server_fd);
+        return -1;
+    }
+    return server_fd;
+}
+
+uint64_t raise_fd_limit(void) {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) < 0) {
+        perror("getrlimit");
+        return 0;
+    }
+    if (rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &rl) < 0) {
+            perror("setrlimit");
+            getrlimit(RLIMIT_NOFILE, &rl);
+        }
+    }
+    return rl.rlim_cur == RLIM_INFINITY ? UINT64_MAX : (uint64_t)rl.rlim_cur;
+}
+
+/**
+ * @brief Tells the simulator that the slot of the application has something for it.
+ */
+static void client_notify(client_conn_t *conn) {
+    shm_region_t *region = conn->region;
+    atomic_fetch_or(&region->pending[conn->index / 64], 1ull << (conn->index % 64));
+    atomic_fetch_add(&region->doorbell, 1);
+    if (atomic_load(&region->sim_waiting)) futex_wake(&region->doorbell);
+}
+
+static int client_connect_socket(client_conn_t *conn) {
+    int sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sockfd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, SOCKET_PATH, sizeof(addr.sun_path) - 1);
+
+    if (connect(sockfd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("connect");
+        close(sockfd);
+        return -1;
+    }
+    conn->sockfd = sockfd;
+    return 0;
+}
+
+static int client_connect_shm(client_conn_t *conn) {
+    int fd = shm_open(SHM_PATH, O_RDWR, 0);
+    if (fd < 0) {
+        perror("shm_open");
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(shm_region_t)) {
+        fprintf(stderr, "%s is not a simulator segment of this version\n", SHM_PATH);
+        close(fd);
+        return -1;
+    }
+    shm_region_t *region = mmap(NULL, sizeof(shm_region_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED) {
+        perror("mmap shm");
+        return -1;
+    }
+    if (memcmp(region->magic, SHM_MAGIC, sizeof(region->magic)) != 0 || region->slots != SHM_MAX_CLIENTS ||
+        atomic_load(&region->closed)) {
+        fprintf(stderr, "%s is not a running simulator of this version\n", SHM_PATH);
+        munmap(region, sizeof(shm_region_t));
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < SHM_MAX_CLIENTS; i++) {
+        uint32_t expected = SHM_SLOT_FREE;
+        if (atomic_compare_exchange_strong(&region->slot[i].state, &expected, SHM_SLOT_OPEN)) {
+            atomic_store(&region->slot[i].owner, (int32_t)getpid());
+            conn->region = region;
+            conn->index = i;
+            client_notify(conn);
+            return 0;
+        }
+    }
+    fprintf(stderr, "No free slot in %s, %d applications are connected\n", SHM_PATH, SHM_MAX_CLIENTS);
+    munmap(region, sizeof(shm_region_t));
+    return -1;
+}
+
+int client_connect(client_conn_t *conn, transport_en transport) {
+    *conn = (client_conn_t){ .transport = transport, .sockfd = -1 };
+    return transport == TRANSPORT_SHM ? client_connect_shm(conn) : client_connect_socket(conn);
+}
+
+ssize_t client_write(client_conn_t *conn, const void *buf, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        if (conn->transport == TRANSPORT_SOCKET) {
+            ssize_t n = write(conn->sockfd, (const uint8_t *)buf + done, len - done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return -1;
+            done += (size_t)n;
+            continue;
+        }
+        shm_ring_t *ring = &conn->region->slot[conn->index].to_sim;
+        size_t n = shm_ring_write(ring, (const uint8_t *)buf + done, len - done);
+        if (n > 0) {
+            done += n;
+            client_notify(conn);
+        } else if (atomic_load(&conn->region->closed) ||
+                   atomic_load(&conn->region->slot[conn->index].state) != SHM_SLOT_OPEN) {
+            errno = EPIPE;
+            return -1;
+        } else {
+            shm_ring_wait_writable(ring, 1000);
+        }
+    }
+    return (ssize_t)len;
+}
+
+ssize_t client_read(client_conn_t *conn, void *buf, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        if (conn->transport == TRANSPORT_SOCKET) {
+            ssize_t n = read(conn->sockfd, (uint8_t *)buf + done, len - done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return n;
+            done += (size_t)n;
+            continue;
+        }
+        shm_ring_t *ring = &conn->region->slot[conn->index].to_app;
+        size_t n = shm_ring_read(ring, (uint8_t *)buf + done, len - done);
+        if (n > 0) {
+            done += n;
+        } else if (atomic_load(&conn->region->closed) ||
+                   atomic_load(&conn->region->slot[conn->index].state) != SHM_SLOT_OPEN) {
+            return 0;                               // Simulator stopped, or dropped the application
+        } else {
+            shm_ring_wait_readable(ring, 1000);     // Wakes up now and then to notice a simulator that stopped
+        }
+    }
+    return (ssize_t)len;
+}
+
+void client_close(client_conn_t *conn) {
+    if (conn->transport == TRANSPORT_SOCKET) {
+        if (conn->sockfd >= 0) close(conn->sockfd);
+        conn->sockfd = -1;
+        return;
+    }
+    if (!conn->region) return;
+    atomic_store(&conn->region->slot[conn->index].state, SHM_SLOT_CLOSED);
+    client_notify(conn);
+    munmap(conn->region, sizeof(shm_region_t));
+    conn->region = NULL;
+}
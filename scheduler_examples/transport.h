@@ -0,0 +1,187 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+ * Transports between the applications and the simulator. Both carry the same byte stream
+ * (msg_t messages, and the burst records of a SUBMIT), so the protocol does not change:
+ *
+ *  - TRANSPORT_SOCKET: a SOCK_STREAM connection on SOCKET_PATH, one read/write per message.
+ *  - TRANSPORT_SHM: a slot in a shared memory segment (SHM_PATH) holding two single-producer
+ *    single-consumer byte rings, one per direction. Sending a message is a copy and an atomic
+ *    store; the peer is only woken up with a futex when it announced that it went to sleep.
+ *
+ * The simulator uses one transport for all clients, selected at startup.
+ */
+
+#define SHM_PATH "/ossim.shm"
+#define SHM_MAGIC "OSSHM002"
+#define SHM_MAX_CLIENTS 1024
+#define SHM_RING_BYTES 4096                 // Per direction, a power of two
+#define SHM_SPIN_LOOPS 2000                 // Polls of a ring before sleeping on it
+#define SHM_REAP_MS 1000                    // How often the simulator looks for applications that died
+
+typedef enum {
+    TRANSPORT_SOCKET = 0,
+    TRANSPORT_SHM,
+} transport_en;
+
+typedef enum {
+    SHM_SLOT_FREE = 0,                      // Available to the next application
+    SHM_SLOT_OPEN,                          // Claimed by an application
+    SHM_SLOT_CLOSED,                        // Application is gone, the simulator frees the slot
+    SHM_SLOT_DROPPED,                       // Simulator dropped the application, freed once it is gone
+} shm_slot_state_en;
+
+// Byte ring with one producer and one consumer. head and tail count bytes and wrap around.
+typedef struct {
+    _Atomic uint32_t head;                  // Written by the producer, futex word of a sleeping consumer
+    _Atomic uint32_t tail;                  // Written by the consumer, futex word of a sleeping producer
+    _Atomic uint32_t reader_waiting;        // Consumer sleeps on head
+    _Atomic uint32_t writer_waiting;        // Producer sleeps on tail
+    uint8_t reserved[48];                   // Keeps data off the cache line of the indices
+    uint8_t data[SHM_RING_BYTES];
+} shm_ring_t;
+
+typedef struct shm_slot_st {
+    _Atomic uint32_t state;                 // shm_slot_state_en
+    _Atomic int32_t owner;                  // PID of the application, 0 until it is known
+    uint8_t reserved[56];
+    shm_ring_t to_sim;                      // Application -> simulator
+    shm_ring_t to_app;                      // Simulator -> application
+} shm_slot_t;
+
+typedef struct {
+    char magic[8];                          // SHM_MAGIC
+    uint32_t slots;                         // SHM_MAX_CLIENTS
+    _Atomic uint32_t doorbell;              // Bumped by applications after writing, futex word
+    _Atomic uint32_t sim_waiting;           // Simulator sleeps on doorbell
+    _Atomic uint32_t closed;                // Simulator stopped, applications must give up
+    _Atomic uint32_t notified;              // Set by shm_server_notify(), ends the next shm_server_wait()
+    uint8_t reserved[36];
+    _Atomic uint64_t pending[SHM_MAX_CLIENTS / 64]; // Slots with new data or a state change
+    shm_slot_t slot[SHM_MAX_CLIENTS];
+} shm_region_t;
+
+/**
+ * @brief Copies up to len bytes into a ring without blocking and wakes its consumer if it sleeps.
+ * @return Number of bytes written.
+ */
+size_t shm_ring_write(shm_ring_t *ring, const void *buf, size_t len);
+
+/**
+ * @brief Copies up to len bytes out of a ring without blocking and wakes its producer if it sleeps.
+ * @return Number of bytes read.
+ */
+size_t shm_ring_read(shm_ring_t *ring, void *buf, size_t len);
+
+/**
+ * @brief Number of bytes waiting in a ring.
+ */
+uint32_t shm_ring_available(const shm_ring_t *ring);
+
+/**
+ * @brief Waits until a ring holds at least one byte, spinning briefly before sleeping.
+ * @param timeout_ms Maximum time to sleep, -1 for no limit.
+ * @return 0 if data is available, -1 on timeout or signal.
+ */
+int shm_ring_wait_readable(shm_ring_t *ring, int timeout_ms);
+
+/**
+ * @brief Creates the shared memory segment of the simulator, replacing a stale one.
+ * @return The mapped region, or NULL on error.
+ */
+shm_region_t *shm_server_open(void);
+
+/**
+ * @brief Unmaps and removes the shared memory segment.
+ */
+void shm_server_close(shm_region_t *region);
+
+/**
+ * @brief Takes the slots flagged since the last call and clears their flags, and the notification.
+ * @param pending One bit per slot, OR-ed with the flagged slots.
+ */
+void shm_server_collect(shm_region_t *region, uint64_t pending[SHM_MAX_CLIENTS / 64]);
+
+/**
+ * @brief Sleeps until an application flags a slot, or until the timeout.
+ * @param timeout_ms Maximum time to sleep, 0 to only check, -1 for no limit.
+ * @return Positive if a slot is flagged or a signal arrived, 0 on timeout.
+ */
+int shm_server_wait(shm_region_t *region, int timeout_ms);
+
+/**
+ * @brief Wakes up a thread of the simulator sleeping in shm_server_wait(), or makes its next call return.
+ */
+void shm_server_notify(shm_region_t *region);
+
+/**
+ * @brief Gives up the slot of an application the simulator is done with.
+ *
+ * The slot goes back to the pool of free slots if its application closed it or is gone. Otherwise
+ * it is marked SHM_SLOT_DROPPED, which the application reads as the end of the connection, and
+ * is only freed once the application closes it or dies: it cannot be handed to a new application
+ * while the old one still writes to it.
+ */
+void shm_server_release(shm_region_t *region, uint32_t index);
+
+/**
+ * @brief Marks SHM_SLOT_CLOSED the slots whose application died without closing them.
+ *
+ * Liveness is checked on the PID of the owner, so a PID reused in the meantime keeps the slot
+ * until that process is gone too.
+ * @param pending One bit per slot, OR-ed with the slots marked.
+ */
+void shm_server_reap(shm_region_t *region, uint64_t pending[SHM_MAX_CLIENTS / 64]);
+
+/**
+ * @brief Creates a non-blocking listening Unix socket at socket_path, replacing a stale one.
+ * @return The socket, or -1 on error (reported with perror).
+ */
+int listen_socket(const char *socket_path, int backlog);
+
+/**
+ * @brief Raises the soft limit of open files (RLIMIT_NOFILE) to the hard limit.
+ *
+ * Every socket connection is a file descriptor, on both ends.
+ * @return The soft limit in effect afterwards, UINT64_MAX if unlimited.
+ */
+uint64_t raise_fd_limit(void);
+
+// Connection of an application to the simulator
+typedef struct {
+    transport_en transport;
+    int sockfd;                             // TRANSPORT_SOCKET
+    shm_region_t *region;                   // TRANSPORT_SHM
+    uint32_t index;                         // Slot of the application in region
+} client_conn_t;
+
+/**
+ * @brief Connects an application to the simulator with the given transport.
+ * @return 0 on success, -1 on error (reported with perror).
+ */
+int client_connect(client_conn_t *conn, transport_en transport);
+
+/**
+ * @brief Sends len bytes to the simulator, waiting for room in the ring if needed.
+ * @return len on success, -1 on error.
+ */
+ssize_t client_write(client_conn_t *conn, const void *buf, size_t len);
+
+/**
+ * @brief Receives exactly len bytes from the simulator.
+ * @return len on success, 0 if the simulator went away, -1 on error.
+ */
+ssize_t client_read(client_conn_t *conn, void *buf, size_t len);
+
+/**
+ * @brief Closes the connection, the simulator drops the task.
+ */
+void client_close(client_conn_t *conn);
+
+#endif //TRANSPORT_H